@@ -0,0 +1,101 @@
+#include "../src/bus.h"
+#include "../src/cartridge.h"
+#include "../src/cpu.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+
+using clock_type = std::chrono::high_resolution_clock;
+
+// Reads of $8000-$FFFF to time for each mapper, and how often to switch
+// banks while doing them (a game switches a handful of times a frame).
+const uint64_t READS = 100'000'000;
+const uint64_t READS_PER_SWITCH = 8192;
+
+struct MapperBench {
+    const char *name;
+    uint8_t flags6;
+    uint8_t prg_banks; // 16KB
+    uint8_t chr_banks; // 8KB
+    // Switch to a bank picked by the number, the way a game would.
+    std::function<void(Bus &, uint8_t)> switch_bank;
+};
+
+static std::string write_rom(const MapperBench &bench) {
+    std::string path = (std::filesystem::temp_directory_path() / "nes_mapper_bench.nes").string();
+    std::ofstream file(path, std::ios::binary);
+    const char header[16] = {'N', 'E', 'S', '\x1A', static_cast<char>(bench.prg_banks),
+                             static_cast<char>(bench.chr_banks), static_cast<char>(bench.flags6)};
+    file.write(header, sizeof(header));
+    for (uint32_t i = 0; i < bench.prg_banks * 0x4000u + bench.chr_banks * 0x2000u; i++) {
+        file.put(static_cast<char>(i * 7 + (i >> 13)));
+    }
+    return path;
+}
+
+// Where each run's sum of the bytes read goes, to keep the reads from being
+// optimized away.
+static volatile uint64_t sink;
+
+// Read all of PRG space over and over through the bus, as the CPU fetches
+// it, optionally switching banks every so often. Returns reads per second.
+static double run(Bus &bus, const MapperBench &bench, bool switching) {
+    uint64_t sum = 0;
+    uint8_t bank = 0;
+    auto start = clock_type::now();
+    for (uint64_t done = 0; done < READS; done += READS_PER_SWITCH) {
+        if (switching) {
+            bench.switch_bank(bus, ++bank);
+        }
+        for (uint32_t i = 0; i < READS_PER_SWITCH; i++) {
+            sum += bus.read(0x8000 | ((done + i) & 0x7FFF));
+        }
+    }
+    std::chrono::duration<double> elapsed = clock_type::now() - start;
+
+    sink = sum;
+    return READS / elapsed.count();
+}
+
+int main() {
+    const MapperBench benches[] = {
+        {"NROM", 0x00, 2, 1, [](Bus &, uint8_t) {}},
+        {"MMC1", 0x10, 16, 4, [](Bus &bus, uint8_t bank) {
+            // Five serial writes to the PRG bank register.
+            for (int bit = 0; bit < 5; bit++) {
+                bus.write(0xE000, bank >> bit);
+            }
+        }},
+        {"UxROM", 0x20, 8, 0, [](Bus &bus, uint8_t bank) { bus.write(0x8000, bank); }},
+        {"CNROM", 0x30, 2, 4, [](Bus &bus, uint8_t bank) { bus.write(0x8000, bank); }},
+        {"MMC3", 0x40, 16, 8, [](Bus &bus, uint8_t bank) {
+            bus.write(0x8000, 6);
+            bus.write(0x8001, bank);
+        }},
+    };
+
+    std::cout << "Mapper   Fixed (reads/s)   Switching (reads/s)   Ratio" << std::endl;
+    for (const MapperBench &bench: benches) {
+        Cartridge cartridge;
+        if (!cartridge.load(write_rom(bench))) {
+            return 1;
+        }
+        Bus bus;
+        Cpu cpu(&bus);
+        bus.connect_cpu(&cpu);
+        bus.load_cartridge(&cartridge);
+
+        // Best of a few runs each, to keep noise out of the ratio.
+        double fixed = 0, switching = 0;
+        for (int i = 0; i < 3; i++) {
+            fixed = std::max(fixed, run(bus, bench, false));
+            switching = std::max(switching, run(bus, bench, true));
+        }
+        std::printf("%-8s %15.3e   %19.3e   %5.3f\n", bench.name, fixed, switching, switching / fixed);
+    }
+    return 0;
+}
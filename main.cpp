@@ -1,17 +1,84 @@
 #include "src/cartridge.h"
 #include "src/cpu.h"
 #include "src/bus.h"
+#include "src/rom_index.h"
+#include <chrono>
+#include <cstring>
 #include <thread>
 
+using clock_type = std::chrono::high_resolution_clock;
+
+static void print_usage(const char *program) {
+    std::cout << "Usage: " << program << " <rom> [--index FILE] [--headless (--frames N | --cycles N) [--timing-only]]" << std::endl;
+}
+
+// Run the emulator as fast as possible for a fixed number of frames or CPU
+// cycles, then report how fast it went. Used for regression and load tests.
+static void run_headless(Bus *bus, Cpu *cpu, Ppu *ppu, uint64_t frames, uint64_t cycles) {
+    auto start = clock_type::now();
+    if (frames) {
+        for (uint64_t i = 0; i < frames; i++) {
+            bus->run_frame();
+        }
+    } else {
+        bus->run_until(cycles);
+    }
+    std::chrono::duration<double> elapsed = clock_type::now() - start;
+
+    double seconds = elapsed.count();
+    std::cout << "Frames:        " << ppu->get_frame() << std::endl;
+    std::cout << "CPU cycles:    " << cpu->get_total_cycles() << std::endl;
+    std::cout << "Wall time:     " << seconds << " s" << std::endl;
+    std::cout << "Frames/s:      " << ppu->get_frame() / seconds << std::endl;
+    std::cout << "CPU cycles/s:  " << cpu->get_total_cycles() / seconds << std::endl;
+}
+
 int main(int argc, char **argv) {
     if (argc < 2) {
         std::cerr << "No ROM file was passed in!" << std::endl;
-        std::cout << "Usage: " << argv[0] << " <rom>" << std::endl;
+        print_usage(argv[0]);
         return 1;
     }
     std::string path = argv[1];
+
+    bool headless = false;
+    bool timing_only = false;
+    uint64_t frames = 0;
+    uint64_t cycles = 0;
+    std::string index_path;
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (std::strcmp(argv[i], "--timing-only") == 0) {
+            timing_only = true;
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+            cycles = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--index") == 0 && i + 1 < argc) {
+            index_path = argv[++i];
+        } else {
+            std::cerr << "Unknown argument " << argv[i] << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (headless && !frames == !cycles) {
+        std::cerr << "Headless mode needs either --frames or --cycles" << std::endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // A ROM in the library index (see nes_romdb) is loaded with its checked
+    // and corrected header info.
+    RomIndex index;
+    const RomIndex::Entry *indexed = nullptr;
+    if (!index_path.empty() && index.load(index_path)) {
+        indexed = index.find(path);
+    }
+
     auto cartridge = new Cartridge();
-    if (!cartridge->load(path)) {
+    if (!cartridge->load(path, indexed ? &indexed->info : nullptr)) {
         LOG_ERROR("Could not load ROM at path " << path)
         return 1;
     }
@@ -23,18 +90,24 @@ int main(int argc, char **argv) {
     bus->load_cartridge(cartridge);
     cpu->initialize();
 
-    // Each cycle is 1/60th of a second
-    auto delay = std::chrono::microseconds(1000000 / 60);
-    using clock = std::chrono::high_resolution_clock;
+    if (headless) {
+        ppu->set_timing_only(timing_only);
+        run_headless(bus, cpu, ppu, frames, cycles);
+        return 0;
+    }
+
+    // Each frame is 1/60th of a second (1/50th on PAL consoles)
+    double frames_per_second = region_timing(cartridge->get_region()).frames_per_second();
+    auto delay = std::chrono::microseconds(static_cast<int64_t>(1000000 / frames_per_second));
     using microseconds = std::chrono::microseconds;
     while (true) {
-        auto start = clock::now();
+        auto start = clock_type::now();
 
-        // Perform one cycle.
-        bus->cycle();
+        // Run the emulator for one frame.
+        bus->run_frame();
 
-        // Sleep for the remainder of the delay (minus the amount of time the cycle took)
-        auto duration = clock::now() - start;
+        // Sleep for the remainder of the delay (minus the amount of time the frame took)
+        auto duration = clock_type::now() - start;
         std::this_thread::sleep_for(std::chrono::duration_cast<microseconds>(delay - duration));
     }
 }
@@ -0,0 +1,48 @@
+#include "block_cache.h"
+
+BasicBlock *BlockCache::find(const uint8_t *code) {
+    RecentBlock &entry = recent[recent_index(code)];
+    if (entry.code == code) {
+        return entry.block;
+    }
+
+    auto it = blocks.find(code);
+    if (it == blocks.end()) {
+        return nullptr;
+    }
+    entry = {code, it->second.get()};
+    return entry.block;
+}
+
+BasicBlock &BlockCache::insert(const uint8_t *code) {
+    auto &block = blocks[code];
+    block = std::make_unique<BasicBlock>();
+    recent[recent_index(code)] = {code, block.get()};
+    return *block;
+}
+
+void BlockCache::invalidate_page(const uint8_t *page) {
+    for (auto it = blocks.begin(); it != blocks.end();) {
+        if (it->first >= page && it->first < page + 0x100) {
+            dropped.push_back(std::move(it->second));
+            it = blocks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto &entry: recent) {
+        if (entry.code >= page && entry.code < page + 0x100) {
+            entry = {};
+        }
+    }
+}
+
+void BlockCache::clear() {
+    blocks.clear();
+    dropped.clear();
+    recent.fill({});
+}
+
+size_t BlockCache::recent_index(const uint8_t *code) {
+    return reinterpret_cast<uintptr_t>(code) % 1024;
+}
@@ -0,0 +1,69 @@
+#ifndef NES_BLOCK_CACHE_H
+#define NES_BLOCK_CACHE_H
+
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// A single instruction that has already been fetched and decoded.
+struct DecodedInstruction {
+    uint8_t opcode;
+    uint8_t bytes;   // size of the instruction, including the opcode
+    uint8_t cycles;  // base cycle count (page crossings are added when executed)
+    uint16_t operand;
+};
+
+// A straight run of decoded instructions, ending with the first instruction
+// that changes the flow of control (a branch, jump, return, or BRK). Blocks
+// never cross a 256-byte page, so a bank switch can't change half of one.
+struct BasicBlock {
+    std::vector<DecodedInstruction> instructions;
+
+    // Whether the block is a loop that branches back to its own start and
+    // does nothing but read memory without side effects, like a game polling
+    // PPUSTATUS for vblank or waiting on a flag set by its NMI handler.
+    bool idle_loop = false;
+};
+
+// Cache of decoded basic blocks, keyed by the host address of the block's
+// first byte. Since each bank of PRG-ROM lives at its own host address this
+// acts as a (bank, PC) key: switching banks simply makes the CPU look up a
+// different block, and switching back finds the old one still valid.
+class BlockCache {
+public:
+    // Find the block starting at the given code, or nullptr if there isn't one.
+    BasicBlock *find(const uint8_t *code);
+
+    // Add a new, empty block starting at the given code.
+    BasicBlock &insert(const uint8_t *code);
+
+    // Drop every block that starts in the given 256-byte page (used when
+    // code in RAM is written to). The write may come from the block the CPU
+    // is running, so dropped blocks are only freed by release_dropped().
+    void invalidate_page(const uint8_t *page);
+
+    // Free the blocks dropped since the last call, once none of them are
+    // being run.
+    void release_dropped() { dropped.clear(); }
+
+    void clear();
+private:
+    std::unordered_map<const uint8_t *, std::unique_ptr<BasicBlock>> blocks;
+    std::vector<std::unique_ptr<BasicBlock>> dropped;
+
+    // Small direct-mapped cache in front of the hash map, since most of the
+    // time is spent running the same few blocks over and over.
+    struct RecentBlock {
+        const uint8_t *code;
+        BasicBlock *block;
+    };
+    std::array<RecentBlock, 1024> recent{};
+
+    static size_t recent_index(const uint8_t *code);
+};
+
+
+#endif //NES_BLOCK_CACHE_H
@@ -1,43 +1,111 @@
 #include "bus.h"
+#include <algorithm>
 #include "log.h"
 
+// Size of a single page in the CPU address space.
+const uint16_t PAGE_SIZE = 0x100;
 
 Bus::Bus() {
-    ranges = {
-        {0x0000, 0x1FFF, AddressType::CPU,        &Bus::cpu_read,        &Bus::cpu_write},
-        {0x2000, 0x3FFF, AddressType::PPU,        &Bus::ppu_read,        &Bus::ppu_write},
-        {0x4015, 0x4015, AddressType::APU,        &Bus::apu_read,        &Bus::apu_write},
-        {0x4016, 0x4017, AddressType::Controller, &Bus::controller_read, &Bus::controller_write},
-        {0x8000, 0xFFFF, AddressType::Cartridge,  &Bus::cartridge_read,  &Bus::cartridge_write},
-    };
+    map_handler(0x00, 0xFF, &Bus::unmapped_read,  &Bus::unmapped_write);
+    map_handler(0x20, 0x3F, &Bus::ppu_read,       &Bus::ppu_write);
+    map_handler(0x40, 0x40, &Bus::io_read,        &Bus::io_write);
+    map_handler(0x60, 0x7F, &Bus::prg_ram_read,   &Bus::prg_ram_write);
+    map_handler(0x80, 0xFF, &Bus::cartridge_read, &Bus::cartridge_write);
+
+    // The 2KB of internal RAM is mirrored four times across $0000-$1FFF,
+    // so each of those pages points straight into the same host memory.
+    for (uint16_t page = 0x00; page <= 0x1F; page++) {
+        uint8_t *ram = &memory[(page & 0x07) * PAGE_SIZE];
+        map_page(page, ram, ram);
+    }
 }
 
 uint8_t Bus::read(uint16_t address) {
-    for (auto range: ranges) {
-        if (address >= range.start && address <= range.end) {
-            std::string name = get_address_type_name(range.type);
-            LOG_TRACE("Reading from " << name << " at address 0x" << std::hex << std::uppercase << address)
-            return (this->*range.read_callback)(address);
-        }
+    const Page &page = pages[address >> 8];
+    if (page.read_memory) {
+        return page.read_memory[address & 0xFF];
     }
-    LOG_ERROR("Invalid read at address 0x" << std::hex << address)
-    return 0x0;
+    return (this->*page.read_callback)(address);
 }
 
 void Bus::write(uint16_t address, uint8_t data) {
-    for (auto range: ranges) {
-        if (address >= range.start && address <= range.end) {
-            std::string name = get_address_type_name(range.type);
-            LOG_TRACE("Writing to " << name << " at address 0x" << std::hex << std::uppercase << address)
-            (this->*range.write_callback)(address, data);
-            return;
+    const Page &page = pages[address >> 8];
+    if (page.write_memory) {
+        page.write_memory[address & 0xFF] = data;
+        return;
+    }
+    (this->*page.write_callback)(address, data);
+}
+
+void Bus::run_until(uint64_t target_cycle) {
+    if (!ppu) {
+        cpu->run_until(target_cycle);
+        return;
+    }
+
+    // The CPU runs freely up to the next scheduled event, which keeps the
+    // PPU out of the hot path entirely. Stopping at each event also means
+    // nothing the CPU reads can change before the target it's given, which
+    // is what lets it skip over idle loops.
+    while (cpu->get_total_cycles() < target_cycle) {
+        uint64_t cycle = std::min(target_cycle, cpu_cycle_at(scheduler.next()));
+        // IRQs are level triggered, so while one is held off by the I flag
+        // we have to check after every instruction whether it's been let in.
+        if (cartridge && cartridge->is_irq_pending()) {
+            cycle = std::min(cycle, cpu->get_total_cycles() + 1);
         }
+        cpu->run_until(cycle);
+        run_events();
     }
-    LOG_ERROR("Invalid write at address 0x" << std::hex << address)
 }
 
-void Bus::cycle() {
-    this->cpu->cycle();
+void Bus::run_frame() {
+    // A frame is not a whole number of CPU cycles, so the CPU carries any
+    // overshoot into the next frame.
+    catch_up_ppu(cpu_time(cpu->get_total_cycles()));
+    run_until(cpu_cycle_at(scheduler.time(Scheduler::Event::FrameEnd)));
+}
+
+uint64_t Bus::cpu_time(uint64_t cycle) const {
+    return cycle * timing.master_cycles_per_cpu_cycle;
+}
+
+uint64_t Bus::cpu_cycle_at(uint64_t time) const {
+    // Rounded up without overflowing, since nothing being scheduled is UINT64_MAX.
+    uint64_t cycle = timing.master_cycles_per_cpu_cycle;
+    return time / cycle + (time % cycle != 0);
+}
+
+void Bus::catch_up_ppu(uint64_t time) {
+    uint64_t dot = timing.master_cycles_per_ppu_dot;
+    ppu->run_until(time / dot);
+    scheduler.schedule(Scheduler::Event::Ppu, ppu->next_event() * dot);
+    scheduler.schedule(Scheduler::Event::FrameEnd, ppu->next_frame() * dot);
+
+    // The mapper's IRQ is worked out ahead of time from how many scanlines
+    // it has left to count, rather than clocking it as each line goes by.
+    unsigned lines = cartridge ? cartridge->scanlines_until_irq() : 0;
+    uint64_t clock = lines ? ppu->next_scanline_clock(lines) : UINT64_MAX;
+    if (clock == UINT64_MAX) {
+        scheduler.cancel(Scheduler::Event::Mapper);
+    } else {
+        scheduler.schedule(Scheduler::Event::Mapper, clock * dot);
+    }
+}
+
+void Bus::run_events() {
+    uint64_t time = cpu_time(cpu->get_total_cycles());
+    if (scheduler.is_due(Scheduler::Event::Ppu, time) || scheduler.is_due(Scheduler::Event::FrameEnd, time) ||
+        scheduler.is_due(Scheduler::Event::Mapper, time)) {
+        catch_up_ppu(time);
+    }
+
+    // Interrupts are only taken between instructions.
+    if (ppu->poll_nmi()) {
+        cpu->nmi();
+    } else if (cartridge && cartridge->is_irq_pending() && !cpu->is_irq_masked()) {
+        cpu->irq();
+    }
 }
 
 void Bus::connect_cpu(Cpu *cpu) {
@@ -48,27 +116,136 @@ void Bus::connect_cpu(Cpu *cpu) {
 void Bus::load_cartridge(Cartridge *cartridge) {
     LOG_TRACE("Connecting cartridge to the main bus...")
     this->cartridge = cartridge;
+    timing = region_timing(cartridge->get_region());
+    if (ppu) {
+        ppu->set_region(cartridge->get_region());
+        ppu->connect_cartridge(cartridge);
+    }
+    map_cartridge();
 }
 
 void Bus::connect_ppu(Ppu *ppu) {
     LOG_TRACE("Connecting PPU to the main bus...")
     this->ppu = ppu;
+    if (cartridge) {
+        ppu->set_region(cartridge->get_region());
+        ppu->connect_cartridge(cartridge);
+    }
 }
 
-uint8_t Bus::cpu_read(uint16_t address) {
-    return memory[address];
+void Bus::map_page(uint8_t page, const uint8_t *read_memory, uint8_t *write_memory) {
+    pages[page].read_memory = read_memory;
+    pages[page].write_memory = write_memory;
 }
 
-void Bus::cpu_write(uint16_t address, uint8_t data) {
-    memory[address] = data;
+const uint8_t *Bus::page_memory(uint16_t address) {
+    return pages[address >> 8].read_memory;
+}
+
+void Bus::map_cartridge() {
+    // PRG-ROM is read straight from the selected bank, but writes still go
+    // through the cartridge so the mapper can see them.
+    for (uint16_t page = 0x80; page <= 0xFF; page++) {
+        map_page(page, cartridge->prg_page(page * PAGE_SIZE), nullptr);
+    }
+
+    // PRG-RAM is read directly too, but writes to RAM that's saved go
+    // through the cartridge so it knows what to flush.
+    for (uint16_t page = 0x60; page <= 0x7F; page++) {
+        uint8_t *ram = cartridge->prg_ram_page(page * PAGE_SIZE);
+        map_page(page, ram, cartridge->is_prg_ram_saved() ? nullptr : ram);
+    }
+
+    if (ppu) {
+        ppu->map_cartridge();
+    }
+
+    // The CPU may be part way through a cached block from a bank that was
+    // just switched out.
+    if (cpu) {
+        cpu->end_block();
+    }
+}
+
+void Bus::map_handler(uint8_t first, uint8_t last,
+                      uint8_t (Bus::*read_callback)(uint16_t),
+                      void (Bus::*write_callback)(uint16_t, uint8_t)) {
+    for (uint16_t page = first; page <= last; page++) {
+        pages[page] = {nullptr, nullptr, read_callback, write_callback};
+    }
 }
 
 uint8_t Bus::ppu_read(uint16_t address) {
-    return ppu->cpu_read(address);
+    catch_up_ppu(cpu_time(cpu->get_cycle()));
+    // The eight PPU registers are mirrored every 8 bytes through $3FFF.
+    return ppu->cpu_read(0x2000 | (address & 0x0007));
 }
 
 void Bus::ppu_write(uint16_t address, uint8_t data) {
-    ppu->cpu_write(address, data);
+    uint64_t time = cpu_time(cpu->get_cycle());
+    catch_up_ppu(time);
+    ppu->cpu_write(0x2000 | (address & 0x0007), data);
+
+    // The write may have moved the PPU's next event (e.g. turning rendering
+    // on shortens odd frames) or raised an NMI the CPU needs to take now.
+    catch_up_ppu(time);
+    if (ppu->is_nmi_pending()) {
+        cpu->stop();
+    }
+}
+
+void Bus::oam_dma(uint8_t page) {
+    uint64_t cycle = cpu->get_cycle();
+    if (ppu) {
+        catch_up_ppu(cpu_time(cycle));
+
+        // Copy the whole page at once, reading it through the bus only when
+        // it isn't plain memory.
+        const uint8_t *source = page_memory(page << 8);
+        uint8_t data[256];
+        if (!source) {
+            for (uint16_t i = 0; i < 256; i++) {
+                data[i] = read((page << 8) | i);
+            }
+            source = data;
+        }
+        ppu->write_oam(source);
+
+        // Sprite 0 may have moved, which moves its hit.
+        catch_up_ppu(cpu_time(cycle));
+    }
+
+    // The CPU is halted for 256 reads and 256 writes, plus one cycle to
+    // halt and one more if it has to wait for a read cycle to start on.
+    // See https://www.nesdev.org/wiki/PPU_registers#OAMDMA
+    cpu->stall(513 + ((cycle + 1) & 1));
+}
+
+uint8_t Bus::io_read(uint16_t address) {
+    switch (address) {
+        case 0x4015: return apu_read(address);
+        case 0x4016:
+        case 0x4017: return controller_read(address);
+        default:     return unmapped_read(address);
+    }
+}
+
+void Bus::io_write(uint16_t address, uint8_t data) {
+    switch (address) {
+        case 0x4014: oam_dma(data); break;
+        case 0x4015: apu_write(address, data); break;
+        case 0x4016:
+        case 0x4017: controller_write(address, data); break;
+        default:
+            // Games write the APU's channel registers ($4000-$4013) all the
+            // time, so they go to the APU rather than being reported.
+            if (address <= 0x4013) {
+                apu_write(address, data);
+            } else {
+                unmapped_write(address, data);
+            }
+            break;
+    }
 }
 
 uint8_t Bus::apu_read(uint16_t address) {
@@ -94,16 +271,49 @@ uint8_t Bus::cartridge_read(uint16_t address) {
 }
 
 void Bus::cartridge_write(uint16_t address, uint8_t data) {
-    cartridge->prg_write(address, data);
+    // A bank switch part way through a frame only affects what's drawn
+    // after it.
+    uint64_t time = cpu_time(cpu->get_cycle());
+    if (ppu) {
+        catch_up_ppu(time);
+    }
+
+    // Writes to cartridge space are the only way a mapper can switch banks,
+    // so re-point everything at the new banks afterwards.
+    unsigned lines = cartridge->scanlines_until_irq();
+    bool mapped = cartridge->prg_write(address, data);
+    if (mapped) {
+        map_cartridge();
+    }
+    if (ppu && (mapped || cartridge->scanlines_until_irq() != lines)) {
+        // The next sprite 0 hit may have moved with the banks, and the
+        // write may have set up the mapper's IRQ, which the CPU has to stop
+        // for if it's sooner than it was running to.
+        uint64_t next = scheduler.next();
+        catch_up_ppu(time);
+        if (mapped || scheduler.next() != next) {
+            cpu->stop();
+        }
+    }
+}
+
+uint8_t Bus::prg_ram_read(uint16_t address) {
+    return cartridge ? cartridge->prg_ram_read(address) : unmapped_read(address);
 }
 
-std::string Bus::get_address_type_name(Bus::AddressType type) {
-    switch (type) {
-        case AddressType::CPU: return "CPU";
-        case AddressType::APU: return "APU";
-        case AddressType::PPU: return "PPU";
-        case AddressType::Controller: return "Controller";
-        case AddressType::Cartridge: return "Cartridge PRG-ROM";
-        default: return "Unknown";
+void Bus::prg_ram_write(uint16_t address, uint8_t data) {
+    if (cartridge) {
+        cartridge->prg_ram_write(address, data);
+    } else {
+        unmapped_write(address, data);
     }
 }
+
+uint8_t Bus::unmapped_read(uint16_t address) {
+    LOG_ERROR("Invalid read at address 0x" << std::hex << address)
+    return 0x0;
+}
+
+void Bus::unmapped_write(uint16_t address, uint8_t /*data*/) {
+    LOG_ERROR("Invalid write at address 0x" << std::hex << address)
+}
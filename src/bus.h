@@ -1,55 +1,89 @@
 #ifndef NES_BUS_H
 #define NES_BUS_H
 
+#include <array>
 #include <cstdint>
 #include <cstdlib>
-#include <vector>
 #include "cartridge.h"
 #include "cpu.h"
 #include "ppu.h"
+#include "region.h"
+#include "scheduler.h"
 
 class Bus {
 public:
     Bus();
     virtual uint8_t read(uint16_t address);
     virtual void write(uint16_t address, uint8_t data);
-    void cycle();
+    // Run the CPU until it reaches the given cycle, catching the PPU up and
+    // delivering its interrupts as their scheduled events come due.
+    void run_until(uint64_t target_cycle);
+    // Run the emulator until the PPU finishes the current frame.
+    void run_frame();
+    // Load a cartridge, switching to the timing of the region it's for.
     void load_cartridge(Cartridge *cartridge);
     void connect_cpu(Cpu *cpu);
     void connect_ppu(Ppu *ppu);
+
+    // Point a 256-byte page of the CPU address space directly at host memory.
+    // Passing a null pointer sends that kind of access to the page's handler
+    // instead (e.g. ROM pages are read directly but written through the mapper).
+    void map_page(uint8_t page, const uint8_t *read_memory, uint8_t *write_memory);
+
+    // Host memory for the page containing the address, or nullptr if reads
+    // from the page go through a handler.
+    const uint8_t *page_memory(uint16_t address);
+
+    // Re-point the PRG pages ($8000-$FFFF) at the banks currently selected
+    // by the cartridge's mapper, and $6000-$7FFF at its PRG-RAM.
+    void map_cartridge();
 private:
-    enum class AddressType {
-        CPU,
-        PPU,
-        APU,
-        Controller,
-        Cartridge,
-    };
-    struct AddressRange {
-        uint16_t start;
-        uint16_t end;
-        AddressType type;
+    // One entry for each 256-byte page of the CPU address space. Reads and
+    // writes use the host pointer when one is set, otherwise they fall back
+    // to the handler (used for memory-mapped I/O).
+    struct Page {
+        const uint8_t *read_memory;
+        uint8_t *write_memory;
         uint8_t (Bus::*read_callback)(uint16_t);
         void (Bus::*write_callback)(uint16_t, uint8_t);
     };
 
-    std::vector<AddressRange> ranges;
-    Cpu *cpu;
-    Ppu *ppu;
-    Cartridge *cartridge;
-    uint8_t memory[8192];
+    std::array<Page, 256> pages;
+    Cpu *cpu = nullptr;
+    Ppu *ppu = nullptr;
+    Cartridge *cartridge = nullptr;
+    uint8_t memory[2048] = {};
+    Scheduler scheduler;
+    RegionTiming timing = NTSC_TIMING;
+
+    void map_handler(uint8_t first, uint8_t last,
+                     uint8_t (Bus::*read_callback)(uint16_t),
+                     void (Bus::*write_callback)(uint16_t, uint8_t));
+
+    // The master clock time a CPU cycle starts at, and the first CPU cycle
+    // that starts at or after a master clock time.
+    [[nodiscard]] uint64_t cpu_time(uint64_t cycle) const;
+    [[nodiscard]] uint64_t cpu_cycle_at(uint64_t time) const;
+    // Run the PPU up to the given master clock time and reschedule its events.
+    void catch_up_ppu(uint64_t time);
+    // Handle the events that are due at the CPU's current time.
+    void run_events();
 
-    uint8_t cpu_read(uint16_t address);
-    void cpu_write(uint16_t address, uint8_t data);
     uint8_t ppu_read(uint16_t address);
     void ppu_write(uint16_t address, uint8_t data);
+    void oam_dma(uint8_t page);
+    uint8_t io_read(uint16_t address);
+    void io_write(uint16_t address, uint8_t data);
     uint8_t apu_read(uint16_t address);
     void apu_write(uint16_t address, uint8_t data);
     uint8_t controller_read(uint16_t address);
     void controller_write(uint16_t address, uint8_t data);
+    uint8_t prg_ram_read(uint16_t address);
+    void prg_ram_write(uint16_t address, uint8_t data);
     uint8_t cartridge_read(uint16_t address);
     void cartridge_write(uint16_t address, uint8_t data);
-    std::string get_address_type_name(AddressType type);
+    uint8_t unmapped_read(uint16_t address);
+    void unmapped_write(uint16_t address, uint8_t data);
 };
 
 #endif //NES_BUS_H
@@ -1,98 +1,168 @@
 #include "cartridge.h"
 
+#include <algorithm>
+#include <filesystem>
 #include <memory>
+#include "mappers/mapper_cnrom.h"
+#include "mappers/mapper_mmc1.h"
+#include "mappers/mapper_mmc3.h"
 #include "mappers/mapper_nrom.h"
+#include "mappers/mapper_uxrom.h"
 
-bool Cartridge::load(const std::string &path) {
+bool Cartridge::load(const std::string &path, const RomInfo *known_info) {
     LOG("Loading ROM from path " << path)
-    std::ifstream file(path, std::ios_base::binary | std::ios_base::in);
-    if (!file || !file.is_open()) {
+    std::shared_ptr<const RomImage> image = RomImage::map_file(path);
+    if (!image) {
         LOG_ERROR("Could not open ROM file at path " << path)
         return false;
     }
     this->path = path;
-
-    Header header{};
-    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
-        LOG_ERROR("Could not read iNES header from ROM! " << path);
+    if (!load_image(std::move(image), known_info)) {
         return false;
     }
-
-    if (header.constant[0] != 'N' || header.constant[1] != 'E' || header.constant[2] != 'S' ||
-        header.constant[3] != '\x1A') {
-        LOG_ERROR("iNES header is not in valid format. Possibly a different format?")
-        LOG_ERROR("Expected: 4e 45 53 1a")
-        LOG_ERROR("Got:      " << std::hex << unsigned(header.constant[0]) << " " << unsigned(header.constant[1]) << " "
-                               << unsigned(header.constant[2]) << " " << unsigned(header.constant[3]))
-        return false;
+    if (info.battery) {
+        open_save(std::filesystem::path(path).replace_extension(".sav").string());
     }
+    return true;
+}
 
-    if (header.prg_rom_size == 0) {
-        LOG_ERROR("Cartridge has no PRG-ROM! " << path);
+bool Cartridge::load_from_memory(std::span<const uint8_t> bytes, const RomInfo *known_info) {
+    LOG("Loading ROM from memory")
+    path = "(memory)";
+    return load_image(RomImage::copy(bytes), known_info);
+}
+
+bool Cartridge::load_image(std::shared_ptr<const RomImage> image, const RomInfo *known_info) {
+    std::span<const uint8_t> bytes = image->bytes();
+    if (!known_info) {
+        if (!RomInfo::parse(bytes, info)) {
+            LOG_ERROR("Invalid ROM image! " << path)
+            return false;
+        }
+    } else if (bytes.size() < known_info->prg_rom_offset + known_info->prg_rom_size + known_info->chr_rom_size) {
+        // The file has changed since its info was worked out.
+        LOG_ERROR("ROM is smaller than its header says! " << path)
         return false;
+    } else {
+        info = *known_info;
     }
 
-
-    if (has_flag(header.flags6, Trainer)) {
-        // Skip the 512-byte trainer if it exists
-        file.seekg(512, std::ios::cur);
+    if (info.mirror == Mapper::FourScreen) {
+        vram.resize(0x800);
     }
 
-    // The upper half of flags 6 and 7 make up the mapper ID.
-    mapper_id = header.flags6 >> 4 | (header.flags7 & 0xF0);
-    prg_rom_size = header.prg_rom_size;
-    chr_rom_size = header.chr_rom_size;
-    version = has_flag(header.flags7, Nes2FormatA | Nes2FormatB) ? 2 : 1;
-    mirror = has_flag(header.flags6, Mirroring) ? Vertical : Horizontal;
-    system = has_flag(header.flags9, 1) ? PAL : NTSC;
-
-    // Read PRG-ROM into memory
-    prg_memory.resize(0x4000 * prg_rom_size);
-    file.read(reinterpret_cast<char *>(&prg_memory[0]), prg_memory.size());
-
-    // Read CHR-ROM into memory
-    chr_memory.resize(0x2000 * chr_rom_size);
-    file.read(reinterpret_cast<char *>(&chr_memory[0]), chr_memory.size());
+    // PRG-RAM starts out as work RAM, until a save file is opened for it.
+    save.reset();
+    work_ram.assign(info.prg_ram_size, 0);
+    prg_ram = work_ram;
+
+    // PRG-ROM and CHR-ROM are read straight out of the image.
+    rom = std::move(image);
+    prg_memory = bytes.subspan(info.prg_rom_offset, info.prg_rom_size);
+
+    // Cartridges without CHR-ROM have 8KB of CHR-RAM instead.
+    if (info.chr_rom_size) {
+        chr_ram.clear();
+        chr_memory = bytes.subspan(info.prg_rom_offset + info.prg_rom_size, info.chr_rom_size);
+        tiles = TileCache::shared(rom, chr_memory);
+    } else {
+        chr_ram.assign(0x2000, 0);
+        chr_memory = chr_ram;
+        tiles = std::make_shared<TileCache>(chr_ram.data(), chr_ram.size());
+    }
 
-    switch (mapper_id) {
+    switch (info.mapper) {
         case Mapper::NROM:
-            mapper = std::make_unique<MapperNROM>(prg_rom_size);
+            mapper = std::make_unique<MapperNROM>(prg_memory.size(), chr_memory.size());
+            break;
+        case Mapper::MMC1:
+            mapper = std::make_unique<MapperMMC1>(prg_memory.size(), chr_memory.size());
+            break;
+        case Mapper::UxROM:
+            mapper = std::make_unique<MapperUxROM>(prg_memory.size(), chr_memory.size());
+            break;
+        case Mapper::CNROM:
+            mapper = std::make_unique<MapperCNROM>(prg_memory.size(), chr_memory.size());
+            break;
+        case Mapper::MMC3:
+            mapper = std::make_unique<MapperMMC3>(prg_memory.size(), chr_memory.size());
             break;
         default:
-            LOG_ERROR("Mapper " << unsigned(mapper_id) << " is not implemented!")
+            LOG_ERROR("Mapper " << info.mapper << " is not implemented!")
             return false;
     }
+    mapper->set_mirror(info.mirror);
 
     LOG("Successfully loaded ROM!")
     LOG(" - Path: " << this->path)
-    LOG(" - PRG-ROM Banks (16KB): " << unsigned(prg_rom_size) << " (" << unsigned(prg_memory.size() / 1024) << "KB)")
-    LOG(" - CHR-ROM Banks (8KB): " << unsigned(chr_rom_size) << " (" << unsigned(chr_memory.size() / 1024) << "KB)")
-    LOG(" - iNES Format: " << unsigned(version))
-    LOG(" - Mapper ID: " << unsigned(mapper_id))
-    LOG(" - TV System: " << (system == NTSC ? "NTSC" : "PAL"))
+    LOG(" - PRG-ROM Banks (16KB): " << info.prg_rom_size / 0x4000 << " (" << prg_memory.size() / 1024 << "KB)")
+    LOG(" - CHR-ROM Banks (8KB): " << info.chr_rom_size / 0x2000 << " (" << chr_memory.size() / 1024 << "KB)")
+    LOG(" - iNES Format: " << unsigned(info.version))
+    LOG(" - Mapper ID: " << info.mapper)
+    LOG(" - TV System: " << (info.region == Region::NTSC ? "NTSC" : info.region == Region::PAL ? "PAL" : "Dendy"))
     return true;
 }
 
-bool Cartridge::has_flag(uint8_t flags, uint8_t flag) {
-    return (flags & flag) == flag;
+const uint8_t *Cartridge::prg_page(uint16_t address) {
+    return &prg_memory[mapper->get_prg_banks()[(address >> 13) & 0x03] + (address & 0x1F00)];
 }
 
-uint8_t Cartridge::prg_read(uint16_t address) {
-    uint16_t mapped_address = mapper->map_address_prg(address);
-    return prg_memory[mapped_address];
+bool Cartridge::open_save(const std::string &save_path) {
+    if (prg_ram.empty()) {
+        return false;
+    }
+    std::unique_ptr<SaveRam> opened = SaveRam::open(save_path, prg_ram.size());
+    if (!opened) {
+        return false;
+    }
+    LOG(" - Save file: " << save_path)
+    save = std::move(opened);
+    prg_ram = save->bytes();
+    return true;
+}
+
+uint8_t *Cartridge::prg_ram_page(uint16_t address) {
+    // RAM smaller than a page would have to be mirrored within the page.
+    if (prg_ram.size() < 0x100) {
+        return nullptr;
+    }
+    return &prg_ram[(address & 0x1F00) % prg_ram.size()];
+}
+
+uint8_t Cartridge::prg_ram_read(uint16_t address) {
+    return prg_ram.empty() ? 0 : prg_ram[(address & 0x1FFF) % prg_ram.size()];
+}
+
+uint8_t *Cartridge::nametable_page(uint8_t table, uint8_t *ciram) {
+    switch (mapper->get_mirror()) {
+        case Mapper::Horizontal:        return ciram + (table >> 1) * 0x400;
+        case Mapper::Vertical:          return ciram + (table & 0x01) * 0x400;
+        case Mapper::SingleScreenLower: return ciram;
+        case Mapper::SingleScreenUpper: return ciram + 0x400;
+        default:
+            // The cartridge supplies the memory for the last two.
+            return table < 2 ? ciram + table * 0x400 : &vram[(table - 2) * 0x400];
+    }
 }
 
-void Cartridge::prg_write(uint16_t address, uint8_t data) {
-    uint16_t mapped_address = mapper->map_address_prg(address);
-    prg_memory[mapped_address] = data;
+bool Cartridge::prg_write(uint16_t address, uint8_t data) {
+    return mapper->write(address, data);
 }
 
 uint8_t Cartridge::chr_read(uint16_t address) {
-    uint16_t mapped_address = mapper->map_address_chr(address);
-    return chr_memory[mapped_address];
+    return chr_memory[chr_offset(address)];
 }
 
 void Cartridge::chr_write(uint16_t address, uint8_t data) {
-    uint16_t mapped_address = mapper->map_address_chr(address);
-    chr_memory[mapped_address] = data;
+    // Only CHR-RAM can be written to.
+    if (!is_chr_writable()) {
+        return;
+    }
+    uint32_t offset = chr_offset(address);
+    chr_ram[offset] = data;
+    tiles->invalidate(offset);
+}
+
+const uint8_t *Cartridge::chr_row(uint16_t address) {
+    return tiles->row(chr_offset(address));
 }
@@ -3,72 +3,97 @@
 
 
 #include <string>
-#include <fstream>
+#include <span>
 #include <vector>
 #include <memory>
 #include "log.h"
 #include "mappers/mapper.h"
+#include "region.h"
+#include "rom_image.h"
+#include "rom_info.h"
+#include "save_ram.h"
+#include "tile_cache.h"
 
 class Cartridge {
+public:
+    using Mirror = Mapper::Mirror;
 
-    // see https://www.nesdev.org/wiki/INES
-    struct Header {
-        char constant[4];     // ASCII "NES" followed by MS-DOS EOF (0x1A)
-        uint8_t prg_rom_size; // Size of PRG ROM in 16 KB units
-        uint8_t chr_rom_size; // Size of CHR ROM in 8 KB units
-        uint8_t flags6;       // Mapper, mirroring, battery, trainer
-        uint8_t flags7;       // Mapper, VS/Playchoice, NES 2.0
-        uint8_t flags8;       // PRG-RAM size (rarely used extension)
-        uint8_t flags9;       // TV system (rarely used extension)
-        uint8_t flags10;      // TV system, PRG-RAM presence (unofficial, rarely used extension)
-        uint8_t padding[5];   // Unused padding
-    };
-
-    enum Flags6 {
-        Mirroring = 1 << 0,       // Mirroring enabled, horizontal or vertical
-        HasPrgRam = 1 << 1,       // Cartridge has PRG RAM ($6000-7FFF) or other persistent memory
-        Trainer = 1 << 2,         // Trainer exists
-        IgnoreMirroring = 1 << 2, // Ignore mirroring, provide four-screen VRAM
-    };
-
-    enum Flags7 {
-        VSUnisystem = 1 << 0,
-        PlayChoice10 = 1 << 1,
-        Nes2FormatA = 1 << 2,
-        Nes2FormatB = 1 << 3,
-    };
-
-    enum Mirror {
-        Horizontal,
-        Vertical,
-        FourScreen,
-    };
-
-    enum TvSystem {
-        NTSC,
-        PAL,
-    };
-
+private:
     std::string path;
-    TvSystem system;
-    Mirror mirror;
-    uint8_t mapper_id;
-    uint8_t prg_rom_size;
-    uint8_t chr_rom_size;
-    uint8_t prg_ram_size;
-    uint8_t version;
+    RomInfo info;
 
     std::unique_ptr<Mapper> mapper;
-    std::vector<uint8_t> prg_memory;
-    std::vector<uint8_t> chr_memory;
+    std::shared_ptr<const RomImage> rom;
+    std::span<const uint8_t> prg_memory; // views into the ROM image
+    std::span<const uint8_t> chr_memory; // or into chr_ram
+    std::vector<uint8_t> chr_ram;
+    std::span<uint8_t> prg_ram;     // $6000-$7FFF, either work_ram or the save
+    std::vector<uint8_t> work_ram;
+    std::unique_ptr<SaveRam> save;
+    std::shared_ptr<TileCache> tiles;
+    std::vector<uint8_t> vram; // the other 2KB of nametables for four-screen mirroring
 
-    static bool has_flag(uint8_t flags, uint8_t flag);
+    bool load_image(std::shared_ptr<const RomImage> image, const RomInfo *known_info);
+    // Offset into CHR memory of the PPU address.
+    [[nodiscard]] uint32_t chr_offset(uint16_t address) const {
+        return mapper->get_chr_banks()[(address >> 10) & 0x07] + (address & 0x03FF);
+    }
 public:
-    bool load(const std::string& path);
-    uint8_t prg_read(uint16_t address);
-    void prg_write(uint16_t address, uint8_t data);
+    // Load the ROM at the path. If its info is already known (e.g. from a
+    // RomIndex) the header isn't parsed, so corrections to it are kept.
+    bool load(const std::string& path, const RomInfo *known_info = nullptr);
+    // Load a ROM image the caller already has in memory. The bytes are
+    // copied unless an identical image is already loaded.
+    bool load_from_memory(std::span<const uint8_t> bytes, const RomInfo *known_info = nullptr);
+    uint8_t prg_read(uint16_t address) {
+        return prg_memory[mapper->get_prg_banks()[(address >> 13) & 0x03] + (address & 0x1FFF)];
+    }
+    // Host pointer to the 256-byte PRG page currently mapped at the address.
+    const uint8_t *prg_page(uint16_t address);
+
+    // Keep battery-backed PRG-RAM in the save file at the path (load() uses
+    // the ROM's path with a .sav extension). This has to happen before the
+    // cartridge is loaded into the bus. Returns false if the file can't be
+    // opened, in which case the RAM isn't saved.
+    bool open_save(const std::string &save_path);
+    // PRG-RAM at $6000-$7FFF. Reads and writes of work RAM can go straight
+    // to the page (nullptr if there's none), but writes to saved RAM have
+    // to go through prg_ram_write() so they're flushed to the save file.
+    uint8_t *prg_ram_page(uint16_t address);
+    [[nodiscard]] bool is_prg_ram_saved() const { return save != nullptr; }
+    uint8_t prg_ram_read(uint16_t address);
+    void prg_ram_write(uint16_t address, uint8_t data) {
+        if (prg_ram.empty()) {
+            return;
+        }
+        uint32_t offset = (address & 0x1FFF) % prg_ram.size();
+        if (save) {
+            save->write(offset, data);
+        } else {
+            prg_ram[offset] = data;
+        }
+    }
+    // Returns whether the write switched banks (or mirroring), which means
+    // everything pointing into cartridge memory has to be mapped again.
+    bool prg_write(uint16_t address, uint8_t data);
     uint8_t chr_read(uint16_t address);
     void chr_write(uint16_t address, uint8_t data);
+    // Whether the cartridge has CHR-RAM rather than CHR-ROM.
+    [[nodiscard]] bool is_chr_writable() const { return info.chr_rom_size == 0; }
+    // The 8 decoded pixels (2-bit colors) of the tile row at the address.
+    const uint8_t *chr_row(uint16_t address);
+    [[nodiscard]] Mirror get_mirror() const { return mapper->get_mirror(); }
+    [[nodiscard]] const std::array<uint32_t, 8> &get_chr_banks() const { return mapper->get_chr_banks(); }
+    [[nodiscard]] Region get_region() const { return info.region; }
+    [[nodiscard]] const RomInfo &get_info() const { return info; }
+    // Scanline counting for mappers with an IRQ (see Mapper).
+    void clock_scanline() { mapper->clock_scanline(); }
+    [[nodiscard]] unsigned scanlines_until_irq() const { return mapper->scanlines_until_irq(); }
+    [[nodiscard]] bool is_irq_pending() const { return mapper->is_irq_pending(); }
+    // Host pointer to the 1KB of memory the given logical nametable (0-3)
+    // is currently mapped to, which is either part of the PPU's internal
+    // 2KB of VRAM or memory on the cartridge.
+    uint8_t *nametable_page(uint8_t table, uint8_t *ciram);
 };
 
 
@@ -0,0 +1,147 @@
+#include "compositor.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace compositor {
+    // Sprite 0 can't hit on the last pixel of the line.
+    const int LAST_HIT_X = LINE_WIDTH - 2;
+
+    // Number of pixels at the left of the screen that PPUMASK can hide.
+    const int LEFT_COLUMN = 8;
+
+    static uint8_t compose_pixel(uint8_t background, uint8_t sprite) {
+        if ((sprite & SpriteColor) && (!background || !(sprite & SpriteBehind))) {
+            return sprite & SpriteColor;
+        }
+        return background;
+    }
+
+    static int compose_range(const uint8_t *background, const uint8_t *sprites, uint8_t *out, int first_x,
+                             int last_x, const PpuMask &mask) {
+        bool show_background = mask.is_set(PpuMask::ShowBackground);
+        bool show_sprites = mask.is_set(PpuMask::ShowSprites);
+        int hit = -1;
+        for (int x = first_x; x < last_x; x++) {
+            uint8_t bg = background[x];
+            uint8_t sprite = sprites[x];
+            if (!show_background || (x < LEFT_COLUMN && !mask.is_set(PpuMask::ShowLeftBackground))) {
+                bg = 0;
+            }
+            if (!show_sprites || (x < LEFT_COLUMN && !mask.is_set(PpuMask::ShowLeftSprites))) {
+                sprite = 0;
+            }
+            if (hit < 0 && (sprite & SpriteZero) && bg && x <= LAST_HIT_X) {
+                hit = x;
+            }
+            out[x] = compose_pixel(bg, sprite);
+        }
+        return hit;
+    }
+
+    int compose_scalar(const uint8_t *background, const uint8_t *sprites, uint8_t *out, int first_x,
+                       const PpuMask &mask) {
+        return compose_range(background, sprites, out, first_x, LINE_WIDTH, mask);
+    }
+
+#if defined(__SSE2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+    const int LANES = 16;
+
+    // Compose 16 pixels with each layer and'ed with its mask (0xFF where
+    // the layer is shown). Returns a bit for each pixel where sprite 0 hits.
+    static uint16_t compose_lanes(const uint8_t *background, const uint8_t *sprites, uint8_t *out,
+                                  const uint8_t *background_mask, const uint8_t *sprite_mask) {
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        __m128i bg = _mm_and_si128(_mm_loadu_si128((const __m128i *) background),
+                                   _mm_loadu_si128((const __m128i *) background_mask));
+        __m128i sprite = _mm_and_si128(_mm_loadu_si128((const __m128i *) sprites),
+                                       _mm_loadu_si128((const __m128i *) sprite_mask));
+
+        __m128i color = _mm_and_si128(sprite, _mm_set1_epi8(SpriteColor));
+        __m128i transparent = _mm_cmpeq_epi8(color, zero);
+        __m128i bg_transparent = _mm_cmpeq_epi8(bg, zero);
+        __m128i front = _mm_cmpeq_epi8(_mm_and_si128(sprite, _mm_set1_epi8(SpriteBehind)), zero);
+
+        // Show the sprite where it's opaque, and either in front or over a
+        // transparent background.
+        __m128i use_sprite = _mm_andnot_si128(transparent, _mm_or_si128(bg_transparent, front));
+        __m128i result = _mm_or_si128(_mm_and_si128(use_sprite, color), _mm_andnot_si128(use_sprite, bg));
+        _mm_storeu_si128((__m128i *) out, result);
+
+        // The sign bit of each sprite pixel is its sprite 0 flag.
+        return _mm_movemask_epi8(_mm_andnot_si128(bg_transparent, sprite));
+#else
+        uint8x16_t bg = vandq_u8(vld1q_u8(background), vld1q_u8(background_mask));
+        uint8x16_t sprite = vandq_u8(vld1q_u8(sprites), vld1q_u8(sprite_mask));
+
+        uint8x16_t color = vandq_u8(sprite, vdupq_n_u8(SpriteColor));
+        uint8x16_t opaque = vtstq_u8(sprite, vdupq_n_u8(SpriteColor));
+        uint8x16_t bg_opaque = vtstq_u8(bg, bg);
+        uint8x16_t front = vceqq_u8(vandq_u8(sprite, vdupq_n_u8(SpriteBehind)), vdupq_n_u8(0));
+
+        uint8x16_t use_sprite = vandq_u8(opaque, vorrq_u8(vmvnq_u8(bg_opaque), front));
+        vst1q_u8(out, vbslq_u8(use_sprite, color, bg));
+
+        uint8x16_t hits = vandq_u8(vtstq_u8(sprite, vdupq_n_u8(SpriteZero)), bg_opaque);
+        if (vmaxvq_u8(hits) == 0) {
+            return 0;
+        }
+        // NEON has no movemask, but hits are rare enough to find one by one.
+        uint8_t lanes[LANES];
+        vst1q_u8(lanes, hits);
+        uint16_t bits = 0;
+        for (int i = 0; i < LANES; i++) {
+            bits |= (lanes[i] & 1) << i;
+        }
+        return bits;
+#endif
+    }
+
+    int compose(const uint8_t *background, const uint8_t *sprites, uint8_t *out, int first_x, const PpuMask &mask) {
+        // The vector loop works on whole, aligned groups of 16 pixels, and
+        // the left column clipping only applies to the first group.
+        int aligned_x = (first_x + LANES - 1) & ~(LANES - 1);
+        int hit = -1;
+        if (first_x < aligned_x) {
+            hit = compose_range(background, sprites, out, first_x, aligned_x, mask);
+        }
+
+        // Masks for each layer, with the left column ones used for the
+        // first group of pixels.
+        uint8_t background_mask[2][LANES];
+        uint8_t sprite_mask[2][LANES];
+        for (int i = 0; i < LANES; i++) {
+            bool left = i < LEFT_COLUMN;
+            background_mask[0][i] = background_mask[1][i] = mask.is_set(PpuMask::ShowBackground) ? 0xFF : 0x00;
+            sprite_mask[0][i] = sprite_mask[1][i] = mask.is_set(PpuMask::ShowSprites) ? 0xFF : 0x00;
+            if (left && !mask.is_set(PpuMask::ShowLeftBackground)) {
+                background_mask[0][i] = 0x00;
+            }
+            if (left && !mask.is_set(PpuMask::ShowLeftSprites)) {
+                sprite_mask[0][i] = 0x00;
+            }
+        }
+
+        for (int x = aligned_x; x < LINE_WIDTH; x += LANES) {
+            int group = x == 0 ? 0 : 1;
+            uint16_t hits = compose_lanes(&background[x], &sprites[x], &out[x],
+                                          background_mask[group], sprite_mask[group]);
+            if (x + LANES > LAST_HIT_X) {
+                hits &= (1 << (LAST_HIT_X - x + 1)) - 1;
+            }
+            if (hit < 0 && hits) {
+                hit = x + __builtin_ctz(hits);
+            }
+        }
+        return hit;
+    }
+#else
+    int compose(const uint8_t *background, const uint8_t *sprites, uint8_t *out, int first_x, const PpuMask &mask) {
+        return compose_scalar(background, sprites, out, first_x, mask);
+    }
+#endif
+}
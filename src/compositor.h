@@ -0,0 +1,35 @@
+#ifndef NES_COMPOSITOR_H
+#define NES_COMPOSITOR_H
+
+
+#include <cstdint>
+#include "registers/ppumask.h"
+
+// Combines the background and sprite pixels of a scanline into the palette
+// RAM index shown for each pixel, 16 pixels at a time where the CPU has
+// SIMD instructions for it (SSE2, or NEON on 64-bit ARM).
+namespace compositor {
+    constexpr int LINE_WIDTH = 256;
+
+    // Background pixels are palette RAM indexes, or 0 when transparent.
+    // Sprite pixels are palette RAM indexes (always at least 0x11 when
+    // opaque), or'd with these flags.
+    enum SpritePixel {
+        SpriteColor  = 0x1F,
+        SpriteBehind = 1 << 6, // drawn behind the background
+        SpriteZero   = 1 << 7, // comes from sprite 0
+    };
+
+    // Compose the pixels from first_x to the end of the line, hiding each
+    // layer as PPUMASK says (including in the leftmost 8 pixels). Returns
+    // the first pixel where sprite 0 hits the background, or -1 if it
+    // doesn't.
+    int compose(const uint8_t *background, const uint8_t *sprites, uint8_t *out, int first_x, const PpuMask &mask);
+
+    // Plain version of compose(), one pixel at a time.
+    int compose_scalar(const uint8_t *background, const uint8_t *sprites, uint8_t *out, int first_x,
+                       const PpuMask &mask);
+}
+
+
+#endif //NES_COMPOSITOR_H
@@ -12,6 +12,8 @@ using Flag = StatusRegister::Flag;
 
 Cpu::Cpu(Bus *bus) {
     this->bus = bus;
+    this->cycles = 0;
+    this->total_cycles = 0;
 }
 
 // Read a single byte from the bus.
@@ -26,18 +28,22 @@ uint16_t Cpu::read_word(uint16_t address) {
     return (hi << 8) | lo;
 }
 
+// The page a write has to invalidate cached code in, with the mirrors of
+// the internal RAM folded together.
+static uint8_t code_page(uint16_t address) {
+    return address < 0x2000 ? (address >> 8) & 0x07 : address >> 8;
+}
+
 // Write data to the bus.
 void Cpu::write(uint16_t address, uint8_t data) {
     bus->write(address, data);
-}
 
-// Write to the accumulator if we're in Accumulator mode,
-// otherwise write to the bus.
-void Cpu::write_acc(uint16_t address, uint8_t data) {
-    if (current_instruction.mode == AddressingMode::Accumulator) {
-        a = data;
-    } else {
-        write(address, data);
+    // Writing to a page we've decoded code from means its blocks are stale.
+    uint8_t page = code_page(address);
+    if (code_pages.test(page)) {
+        blocks.invalidate_page(bus->page_memory(address));
+        code_pages.reset(page);
+        block_ended = true;
     }
 }
 
@@ -51,6 +57,215 @@ void Cpu::cycle() {
         return;
     }
 
+    // Decrement cycles since we just executed one for this operation.
+    cycles = step() - 1;
+}
+
+// Run whole instructions until the target cycle is reached. Rather than
+// sleeping through each cycle of an instruction like cycle() does, the
+// full cost of each instruction is added to the total up front.
+uint64_t Cpu::run_until(uint64_t target_cycle) {
+    // Finish off any cycles left over from cycle() or an interrupt.
+    total_cycles += cycles;
+    cycles = 0;
+    stopped = false;
+
+    while (total_cycles < target_cycle && !stopped) {
+        const BasicBlock *block = cache_blocks ? find_block(pc) : nullptr;
+        if (block && block->idle_loop) {
+            run_idle_loop(*block, target_cycle);
+            blocks.release_dropped();
+        } else if (block && !block->instructions.empty()) {
+            run_block(*block, target_cycle);
+            blocks.release_dropped();
+        } else {
+            total_cycles += step();
+        }
+    }
+    return total_cycles > target_cycle ? total_cycles - target_cycle : 0;
+}
+
+void Cpu::end_block() {
+    block_ended = true;
+}
+
+void Cpu::stop() {
+    stopped = true;
+    block_ended = true;
+}
+
+void Cpu::stall(uint16_t stall_cycles) {
+    cycles += stall_cycles;
+}
+
+uint64_t Cpu::get_cycle() const {
+    return total_cycles + (cycles ? cycles - 1 : 0);
+}
+
+// Run the instructions of a decoded block until the block ends, the target
+// cycle is reached, or the code underneath it changes.
+void Cpu::run_block(const BasicBlock &block, uint64_t target_cycle) {
+    block_ended = false;
+    for (const DecodedInstruction &instruction: block.instructions) {
+        pc += instruction.bytes;
+        cycles += instruction.cycles;
+        dispatch(instruction.opcode, instruction.operand);
+        total_cycles += cycles;
+        cycles = 0;
+
+        if (block_ended || total_cycles >= target_cycle) {
+            break;
+        }
+    }
+}
+
+// Run an idle loop once, and if that left the CPU in exactly the state it
+// started in, every following time around the loop will do the same until
+// something outside the CPU changes. So we skip ahead by as many whole trips
+// around the loop as fit before the target cycle, which leaves everything
+// (including the final cycle count) exactly as if they had been run.
+void Cpu::run_idle_loop(const BasicBlock &block, uint64_t target_cycle) {
+    uint16_t start = pc;
+    uint8_t start_a = a, start_x = x, start_y = y, start_sp = sp;
+    uint8_t start_status = status.get_value();
+    uint64_t start_cycles = total_cycles;
+
+    run_block(block, target_cycle);
+
+    if (pc != start || stopped || total_cycles >= target_cycle || a != start_a || x != start_x || y != start_y ||
+        sp != start_sp || status.get_value() != start_status) {
+        return;
+    }
+
+    // Stop short of the target so the last trip is run normally.
+    uint64_t period = total_cycles - start_cycles;
+    uint64_t remaining = target_cycle - total_cycles;
+    total_cycles += (remaining - 1) / period * period;
+}
+
+const BasicBlock *Cpu::find_block(uint16_t address) {
+    // Only code that lives in memory can be cached, reading through an I/O
+    // handler could have side effects.
+    const uint8_t *page = bus->page_memory(address);
+    if (!page) {
+        return nullptr;
+    }
+
+    const uint8_t *code = page + (address & 0xFF);
+    const BasicBlock *block = blocks.find(code);
+    return block ? block : decode_block(address, code);
+}
+
+// Decode instructions straight from host memory until one changes the flow
+// of control, or the next one would run off the end of the page.
+const BasicBlock *Cpu::decode_block(uint16_t address, const uint8_t *code) {
+    using Type = Cpu::InstructionType;
+    BasicBlock &block = blocks.insert(code);
+
+    // Code outside of PRG-ROM can be overwritten, so we need to keep track
+    // of it in order to throw the block away when that happens.
+    if (address < 0x8000) {
+        code_pages.set(code_page(address));
+    }
+
+    uint16_t offset = address & 0xFF;
+    bool ended = false;
+    while (!ended) {
+        const Instruction &instruction = instructions[*code];
+        if (offset + instruction.bytes > 0x100) {
+            break;
+        }
+
+        uint16_t operand = 0;
+        if (instruction.bytes > 1) {
+            operand = code[1];
+        }
+        if (instruction.bytes > 2) {
+            operand |= code[2] << 8;
+        }
+        block.instructions.push_back({instruction.opcode, instruction.bytes, instruction.cycles, operand});
+        offset += instruction.bytes;
+        code += instruction.bytes;
+
+        //@formatter:off
+        switch (instruction.type) {
+            case Type::BCC: case Type::BCS: case Type::BEQ: case Type::BMI:
+            case Type::BNE: case Type::BPL: case Type::BVC: case Type::BVS:
+            case Type::BRK: case Type::JMP: case Type::JSR: case Type::RTI:
+            case Type::RTS:
+                ended = true;
+                break;
+            default:
+                break;
+        }
+        //@formatter:on
+    }
+
+    block.idle_loop = is_idle_loop(block, address);
+    return &block;
+}
+
+// Reading any of these has no side effects, or (for PPUSTATUS) the same side
+// effects every time, so reading them over and over is just waiting.
+static bool is_idempotent_read(uint16_t address) {
+    return address < 0x2000 || (address & 0xE007) == 0x2002 || address >= 0x6000;
+}
+
+bool Cpu::is_idle_loop(const BasicBlock &block, uint16_t address) {
+    using Type = Cpu::InstructionType;
+    using Mode = Cpu::AddressingMode;
+
+    if (block.instructions.size() < 2) {
+        return false;
+    }
+
+    // The block has to end with a conditional branch back to its own start.
+    uint16_t end = address;
+    for (const DecodedInstruction &instruction: block.instructions) {
+        end += instruction.bytes;
+    }
+    const DecodedInstruction &last = block.instructions.back();
+    if (instructions[last.opcode].mode != Mode::Relative ||
+        static_cast<uint16_t>(end + static_cast<int8_t>(last.operand)) != address) {
+        return false;
+    }
+
+    // Everything before it may only read memory and update registers.
+    for (size_t i = 0; i < block.instructions.size() - 1; i++) {
+        const DecodedInstruction &decoded = block.instructions[i];
+        const Instruction &instruction = instructions[decoded.opcode];
+
+        //@formatter:off
+        switch (instruction.type) {
+            case Type::LDA: case Type::LDX: case Type::LDY: case Type::BIT:
+            case Type::CMP: case Type::CPX: case Type::CPY: case Type::AND:
+            case Type::ORA: case Type::EOR: case Type::TAX: case Type::TAY:
+            case Type::TXA: case Type::TYA: case Type::CLC: case Type::SEC:
+            case Type::CLV: case Type::NOP:
+                break;
+            default:
+                return false;
+        }
+
+        switch (instruction.mode) {
+            case Mode::Implied:
+            case Mode::Immediate:
+                break;
+            case Mode::ZeroPage:
+                break;
+            case Mode::Absolute:
+                if (!is_idempotent_read(decoded.operand)) return false;
+                break;
+            default:
+                return false;
+        }
+        //@formatter:on
+    }
+    return true;
+}
+
+// Execute the next instruction and return the number of cycles it took.
+uint16_t Cpu::step() {
     // Read the next operation from memory, then increment the program counter.
     uint8_t opcode = read(pc++);
 
@@ -61,23 +276,32 @@ void Cpu::cycle() {
     // Add the predefined number of cycles for each operation.
     cycles += current_instruction.cycles;
 
+    // Fetch the operand bytes that follow the opcode (if any).
+    uint16_t operand = 0;
+    if (current_instruction.bytes > 1) {
+        operand = read(pc++);
+    }
+    if (current_instruction.bytes > 2) {
+        operand |= read(pc++) << 8;
+    }
+
     if (LOG_TRACE_ENABLED) {
         std::string op_name = get_instruction_name(current_instruction.type);
         std::string md_name = get_addressing_mode_name(current_instruction.mode);
         LOG_TRACE("Executing opcode 0x" << std::hex << std::uppercase << unsigned(opcode))
         LOG_TRACE(op_name << " "
                           << md_name << " 0x"
-                          << std::hex << current_address << std::dec << " ("
+                          << std::hex << operand << std::dec << " ("
                           << unsigned(current_instruction.bytes) << " bytes, "
                           << unsigned(current_instruction.cycles) << " cycles)")
     }
 
-    // Call the addressing mode function and execute the operation.
-    (this->*current_instruction.ref_mode)();
-    (this->*current_instruction.ref_operation)();
+    // Jump straight to the handler generated for this opcode.
+    dispatch(opcode, operand);
 
-    // Decrement cycles since we just executed one for this operation.
-    cycles--;
+    uint16_t taken = cycles;
+    cycles = 0;
+    return taken;
 }
 
 // Reset the CPU to it's initial state.
@@ -106,111 +330,492 @@ void Cpu::irq() {
 
 // region Addressing Modes
 
+// Every opcode with its instruction, addressing mode, size in bytes, and
+// base cycle count. BRK is listed with 0 cycles even though it actually
+// takes 7, since those are added in the interrupt method.
+// See https://www.masswerk.at/6502/6502_instruction_set.html
+//@formatter:off
+#define CPU_OPCODES(OP) \
+    OP(0x00, BRK, Implied,     1, 0) \
+    OP(0x01, ORA, IndirectX,   2, 6) \
+    OP(0x02, NOP, Implied,     1, 2) \
+    OP(0x03, NOP, Implied,     1, 2) \
+    OP(0x04, NOP, Implied,     1, 2) \
+    OP(0x05, ORA, ZeroPage,    2, 3) \
+    OP(0x06, ASL, ZeroPage,    2, 5) \
+    OP(0x07, NOP, Implied,     1, 2) \
+    OP(0x08, PHP, Implied,     1, 3) \
+    OP(0x09, ORA, Immediate,   2, 2) \
+    OP(0x0A, ASL, Accumulator, 1, 2) \
+    OP(0x0B, NOP, Implied,     1, 2) \
+    OP(0x0C, NOP, Implied,     1, 2) \
+    OP(0x0D, ORA, Absolute,    3, 4) \
+    OP(0x0E, ASL, Absolute,    3, 6) \
+    OP(0x0F, NOP, Implied,     1, 2) \
+    OP(0x10, BPL, Relative,    2, 2) \
+    OP(0x11, ORA, IndirectY,   2, 5) \
+    OP(0x12, NOP, Implied,     1, 2) \
+    OP(0x13, NOP, Implied,     1, 2) \
+    OP(0x14, NOP, Implied,     1, 2) \
+    OP(0x15, ORA, ZeroPageX,   2, 4) \
+    OP(0x16, ASL, ZeroPageX,   2, 6) \
+    OP(0x17, NOP, Implied,     1, 2) \
+    OP(0x18, CLC, Implied,     1, 2) \
+    OP(0x19, ORA, AbsoluteY,   3, 4) \
+    OP(0x1A, NOP, Implied,     1, 2) \
+    OP(0x1B, NOP, Implied,     1, 2) \
+    OP(0x1C, NOP, Implied,     1, 2) \
+    OP(0x1D, ORA, AbsoluteX,   3, 4) \
+    OP(0x1E, ASL, AbsoluteX,   3, 7) \
+    OP(0x1F, NOP, Implied,     1, 2) \
+    OP(0x20, JSR, Absolute,    3, 6) \
+    OP(0x21, AND, IndirectX,   2, 6) \
+    OP(0x22, NOP, Implied,     1, 2) \
+    OP(0x23, NOP, Implied,     1, 2) \
+    OP(0x24, BIT, ZeroPage,    2, 3) \
+    OP(0x25, AND, ZeroPage,    2, 3) \
+    OP(0x26, ROL, ZeroPage,    2, 5) \
+    OP(0x27, NOP, Implied,     1, 2) \
+    OP(0x28, PLP, Implied,     1, 4) \
+    OP(0x29, AND, Immediate,   2, 2) \
+    OP(0x2A, ROL, Accumulator, 1, 2) \
+    OP(0x2B, NOP, Implied,     1, 2) \
+    OP(0x2C, BIT, Absolute,    3, 4) \
+    OP(0x2D, AND, Absolute,    3, 4) \
+    OP(0x2E, ROL, Absolute,    3, 6) \
+    OP(0x2F, NOP, Implied,     1, 2) \
+    OP(0x30, BMI, Relative,    2, 2) \
+    OP(0x31, AND, IndirectY,   2, 5) \
+    OP(0x32, NOP, Implied,     1, 2) \
+    OP(0x33, NOP, Implied,     1, 2) \
+    OP(0x34, NOP, Implied,     1, 2) \
+    OP(0x35, AND, ZeroPageX,   2, 4) \
+    OP(0x36, ROL, ZeroPageX,   2, 6) \
+    OP(0x37, NOP, Implied,     1, 2) \
+    OP(0x38, SEC, Implied,     1, 2) \
+    OP(0x39, AND, AbsoluteY,   3, 4) \
+    OP(0x3A, NOP, Implied,     1, 2) \
+    OP(0x3B, NOP, Implied,     1, 2) \
+    OP(0x3C, NOP, Implied,     1, 2) \
+    OP(0x3D, AND, AbsoluteX,   3, 4) \
+    OP(0x3E, ROL, AbsoluteX,   3, 7) \
+    OP(0x3F, NOP, Implied,     1, 2) \
+    OP(0x40, RTI, Implied,     1, 6) \
+    OP(0x41, EOR, IndirectX,   2, 6) \
+    OP(0x42, NOP, Implied,     1, 2) \
+    OP(0x43, NOP, Implied,     1, 2) \
+    OP(0x44, NOP, Implied,     1, 2) \
+    OP(0x45, EOR, ZeroPage,    2, 3) \
+    OP(0x46, LSR, ZeroPage,    2, 5) \
+    OP(0x47, NOP, Implied,     1, 2) \
+    OP(0x48, PHA, Implied,     1, 3) \
+    OP(0x49, EOR, Immediate,   2, 2) \
+    OP(0x4A, LSR, Accumulator, 1, 2) \
+    OP(0x4B, NOP, Implied,     1, 2) \
+    OP(0x4C, JMP, Absolute,    3, 3) \
+    OP(0x4D, EOR, Absolute,    3, 4) \
+    OP(0x4E, LSR, Absolute,    3, 6) \
+    OP(0x4F, NOP, Implied,     1, 2) \
+    OP(0x50, BVC, Relative,    2, 2) \
+    OP(0x51, EOR, IndirectY,   2, 5) \
+    OP(0x52, NOP, Implied,     1, 2) \
+    OP(0x53, NOP, Implied,     1, 2) \
+    OP(0x54, NOP, Implied,     1, 2) \
+    OP(0x55, EOR, ZeroPageX,   2, 4) \
+    OP(0x56, LSR, ZeroPageX,   2, 6) \
+    OP(0x57, NOP, Implied,     1, 2) \
+    OP(0x58, CLI, Implied,     1, 2) \
+    OP(0x59, EOR, AbsoluteY,   3, 4) \
+    OP(0x5A, NOP, Implied,     1, 2) \
+    OP(0x5B, NOP, Implied,     1, 2) \
+    OP(0x5C, NOP, Implied,     1, 2) \
+    OP(0x5D, EOR, AbsoluteX,   3, 4) \
+    OP(0x5E, LSR, AbsoluteX,   3, 7) \
+    OP(0x5F, NOP, Implied,     1, 2) \
+    OP(0x60, RTS, Implied,     1, 6) \
+    OP(0x61, ADC, IndirectX,   2, 6) \
+    OP(0x62, NOP, Implied,     1, 2) \
+    OP(0x63, NOP, Implied,     1, 2) \
+    OP(0x64, NOP, Implied,     1, 2) \
+    OP(0x65, ADC, ZeroPage,    2, 3) \
+    OP(0x66, ROR, ZeroPage,    2, 5) \
+    OP(0x67, NOP, Implied,     1, 2) \
+    OP(0x68, PLA, Implied,     1, 4) \
+    OP(0x69, ADC, Immediate,   2, 2) \
+    OP(0x6A, ROR, Accumulator, 1, 2) \
+    OP(0x6B, NOP, Implied,     1, 2) \
+    OP(0x6C, JMP, Indirect,    3, 5) \
+    OP(0x6D, ADC, Absolute,    3, 4) \
+    OP(0x6E, ROR, Absolute,    3, 6) \
+    OP(0x6F, NOP, Implied,     1, 2) \
+    OP(0x70, BVS, Relative,    2, 2) \
+    OP(0x71, ADC, IndirectY,   2, 5) \
+    OP(0x72, NOP, Implied,     1, 2) \
+    OP(0x73, NOP, Implied,     1, 2) \
+    OP(0x74, NOP, Implied,     1, 2) \
+    OP(0x75, ADC, ZeroPageX,   2, 4) \
+    OP(0x76, ROR, ZeroPageX,   2, 6) \
+    OP(0x77, NOP, Implied,     1, 2) \
+    OP(0x78, SEI, Implied,     1, 2) \
+    OP(0x79, ADC, AbsoluteY,   3, 4) \
+    OP(0x7A, NOP, Implied,     1, 2) \
+    OP(0x7B, NOP, Implied,     1, 2) \
+    OP(0x7C, NOP, Implied,     1, 2) \
+    OP(0x7D, ADC, AbsoluteX,   3, 4) \
+    OP(0x7E, ROR, AbsoluteX,   3, 7) \
+    OP(0x7F, NOP, Implied,     1, 2) \
+    OP(0x80, NOP, Implied,     1, 2) \
+    OP(0x81, STA, IndirectX,   2, 6) \
+    OP(0x82, NOP, Implied,     1, 2) \
+    OP(0x83, NOP, Implied,     1, 2) \
+    OP(0x84, STY, ZeroPage,    2, 3) \
+    OP(0x85, STA, ZeroPage,    2, 3) \
+    OP(0x86, STX, ZeroPage,    2, 3) \
+    OP(0x87, NOP, Implied,     1, 2) \
+    OP(0x88, DEY, Implied,     1, 2) \
+    OP(0x89, NOP, Implied,     1, 2) \
+    OP(0x8A, TXA, Implied,     1, 2) \
+    OP(0x8B, NOP, Implied,     1, 2) \
+    OP(0x8C, STY, Absolute,    3, 4) \
+    OP(0x8D, STA, Absolute,    3, 4) \
+    OP(0x8E, STX, Absolute,    3, 4) \
+    OP(0x8F, NOP, Implied,     1, 2) \
+    OP(0x90, BCC, Relative,    2, 2) \
+    OP(0x91, STA, IndirectY,   2, 6) \
+    OP(0x92, NOP, Implied,     1, 2) \
+    OP(0x93, NOP, Implied,     1, 2) \
+    OP(0x94, STY, ZeroPageY,   2, 4) \
+    OP(0x95, STA, ZeroPageX,   2, 4) \
+    OP(0x96, STX, ZeroPageY,   2, 4) \
+    OP(0x97, NOP, Implied,     1, 2) \
+    OP(0x98, TYA, Implied,     1, 2) \
+    OP(0x99, STA, AbsoluteY,   3, 5) \
+    OP(0x9A, TXS, Implied,     1, 2) \
+    OP(0x9B, NOP, Implied,     1, 2) \
+    OP(0x9C, NOP, Implied,     1, 2) \
+    OP(0x9D, STA, AbsoluteX,   3, 5) \
+    OP(0x9E, NOP, Implied,     1, 2) \
+    OP(0x9F, NOP, Implied,     1, 2) \
+    OP(0xA0, LDY, Immediate,   2, 2) \
+    OP(0xA1, LDA, IndirectX,   2, 6) \
+    OP(0xA2, LDX, Immediate,   2, 2) \
+    OP(0xA3, NOP, Implied,     1, 2) \
+    OP(0xA4, LDY, ZeroPage,    2, 3) \
+    OP(0xA5, LDA, ZeroPage,    2, 3) \
+    OP(0xA6, LDX, ZeroPage,    2, 3) \
+    OP(0xA7, NOP, Implied,     1, 2) \
+    OP(0xA8, TAY, Implied,     1, 2) \
+    OP(0xA9, LDA, Immediate,   2, 2) \
+    OP(0xAA, TAX, Implied,     1, 2) \
+    OP(0xAB, NOP, Implied,     1, 2) \
+    OP(0xAC, LDY, Absolute,    3, 4) \
+    OP(0xAD, LDA, Absolute,    3, 4) \
+    OP(0xAE, LDX, Absolute,    3, 4) \
+    OP(0xAF, NOP, Implied,     1, 2) \
+    OP(0xB0, BCS, Relative,    2, 2) \
+    OP(0xB1, LDA, IndirectY,   2, 5) \
+    OP(0xB2, NOP, Implied,     1, 2) \
+    OP(0xB3, NOP, Implied,     1, 2) \
+    OP(0xB4, LDY, ZeroPageX,   2, 4) \
+    OP(0xB5, LDA, ZeroPageX,   2, 4) \
+    OP(0xB6, LDX, ZeroPageY,   2, 4) \
+    OP(0xB7, NOP, Implied,     1, 2) \
+    OP(0xB8, CLV, Implied,     1, 2) \
+    OP(0xB9, LDA, AbsoluteY,   3, 4) \
+    OP(0xBA, TSX, Implied,     1, 2) \
+    OP(0xBB, NOP, Implied,     1, 2) \
+    OP(0xBC, LDY, AbsoluteX,   3, 4) \
+    OP(0xBD, LDA, AbsoluteX,   3, 4) \
+    OP(0xBE, LDX, AbsoluteY,   3, 4) \
+    OP(0xBF, NOP, Implied,     1, 2) \
+    OP(0xC0, CPY, Immediate,   2, 2) \
+    OP(0xC1, CMP, IndirectX,   2, 6) \
+    OP(0xC2, NOP, Implied,     1, 2) \
+    OP(0xC3, NOP, Implied,     1, 2) \
+    OP(0xC4, CPY, ZeroPage,    2, 3) \
+    OP(0xC5, CMP, ZeroPage,    2, 3) \
+    OP(0xC6, DEC, ZeroPage,    2, 5) \
+    OP(0xC7, NOP, Implied,     1, 2) \
+    OP(0xC8, INY, Implied,     1, 2) \
+    OP(0xC9, CMP, Immediate,   2, 2) \
+    OP(0xCA, DEX, Implied,     1, 2) \
+    OP(0xCB, NOP, Implied,     1, 2) \
+    OP(0xCC, CPY, Absolute,    3, 4) \
+    OP(0xCD, CMP, Absolute,    3, 4) \
+    OP(0xCE, DEC, Absolute,    3, 6) \
+    OP(0xCF, NOP, Implied,     1, 2) \
+    OP(0xD0, BNE, Relative,    2, 2) \
+    OP(0xD1, CMP, IndirectY,   2, 5) \
+    OP(0xD2, NOP, Implied,     1, 2) \
+    OP(0xD3, NOP, Implied,     1, 2) \
+    OP(0xD4, NOP, Implied,     1, 2) \
+    OP(0xD5, CMP, ZeroPageX,   2, 4) \
+    OP(0xD6, DEC, ZeroPageX,   2, 6) \
+    OP(0xD7, NOP, Implied,     1, 2) \
+    OP(0xD8, CLD, Implied,     1, 2) \
+    OP(0xD9, CMP, AbsoluteY,   3, 4) \
+    OP(0xDA, NOP, Implied,     1, 2) \
+    OP(0xDB, NOP, Implied,     1, 2) \
+    OP(0xDC, NOP, Implied,     1, 2) \
+    OP(0xDD, CMP, AbsoluteX,   3, 4) \
+    OP(0xDE, DEC, AbsoluteX,   3, 7) \
+    OP(0xDF, NOP, Implied,     1, 2) \
+    OP(0xE0, CPX, Immediate,   2, 2) \
+    OP(0xE1, SBC, IndirectX,   2, 6) \
+    OP(0xE2, NOP, Implied,     1, 2) \
+    OP(0xE3, NOP, Implied,     1, 2) \
+    OP(0xE4, CPX, ZeroPage,    2, 3) \
+    OP(0xE5, SBC, ZeroPage,    2, 3) \
+    OP(0xE6, INC, ZeroPage,    2, 5) \
+    OP(0xE7, NOP, Implied,     1, 2) \
+    OP(0xE8, INX, Implied,     1, 2) \
+    OP(0xE9, SBC, Immediate,   2, 2) \
+    OP(0xEA, NOP, Implied,     1, 2) \
+    OP(0xEB, NOP, Implied,     1, 2) \
+    OP(0xEC, CPX, Absolute,    3, 4) \
+    OP(0xED, SBC, Absolute,    3, 4) \
+    OP(0xEE, INC, Absolute,    3, 6) \
+    OP(0xEF, NOP, Implied,     1, 2) \
+    OP(0xF0, BEQ, Relative,    2, 2) \
+    OP(0xF1, SBC, IndirectY,   2, 5) \
+    OP(0xF2, NOP, Implied,     1, 2) \
+    OP(0xF3, NOP, Implied,     1, 2) \
+    OP(0xF4, NOP, Implied,     1, 2) \
+    OP(0xF5, SBC, ZeroPageX,   2, 4) \
+    OP(0xF6, INC, ZeroPageX,   2, 6) \
+    OP(0xF7, NOP, Implied,     1, 2) \
+    OP(0xF8, SED, Implied,     1, 2) \
+    OP(0xF9, SBC, AbsoluteY,   3, 4) \
+    OP(0xFA, NOP, Implied,     1, 2) \
+    OP(0xFB, NOP, Implied,     1, 2) \
+    OP(0xFC, NOP, Implied,     1, 2) \
+    OP(0xFD, SBC, AbsoluteX,   3, 4) \
+    OP(0xFE, INC, AbsoluteX,   3, 7) \
+    OP(0xFF, NOP, Implied,     1, 2)
+//@formatter:on
+
+// The instruction lookup table, indexed by opcode.
+const std::array<Cpu::Instruction, 256> Cpu::instructions = {{
+#define INSTRUCTION(opcode, type, mode, bytes, cycles) \
+    { opcode, InstructionType::type, AddressingMode::mode, bytes, cycles },
+    CPU_OPCODES(INSTRUCTION)
+#undef INSTRUCTION
+}};
+
+// A dense switch over every opcode, which the compiler turns into a jump
+// table with each case holding that opcode's inlined handler.
+void Cpu::dispatch(uint8_t opcode, uint16_t operand) {
+    switch (opcode) {
+#define DISPATCH(opcode, type, mode, bytes, cycles) \
+        case opcode: execute<InstructionType::type, AddressingMode::mode>(operand); break;
+        CPU_OPCODES(DISPATCH)
+#undef DISPATCH
+    }
+}
+
+template<Cpu::InstructionType T, Cpu::AddressingMode M>
+void Cpu::execute(uint16_t operand) {
+    using Type = Cpu::InstructionType;
+    uint16_t address = resolve<M>(operand);
+    current_address = address;
+
+    //@formatter:off
+    if constexpr (T == Type::ADC) ADC(load<M>(address));
+    else if constexpr (T == Type::AND) AND(load<M>(address));
+    else if constexpr (T == Type::ASL) ASL<M>(address);
+    else if constexpr (T == Type::BCC) BCC(address);
+    else if constexpr (T == Type::BCS) BCS(address);
+    else if constexpr (T == Type::BEQ) BEQ(address);
+    else if constexpr (T == Type::BIT) BIT(load<M>(address));
+    else if constexpr (T == Type::BMI) BMI(address);
+    else if constexpr (T == Type::BNE) BNE(address);
+    else if constexpr (T == Type::BPL) BPL(address);
+    else if constexpr (T == Type::BRK) BRK();
+    else if constexpr (T == Type::BVC) BVC(address);
+    else if constexpr (T == Type::BVS) BVS(address);
+    else if constexpr (T == Type::CLC) CLC();
+    else if constexpr (T == Type::CLD) CLD();
+    else if constexpr (T == Type::CLI) CLI();
+    else if constexpr (T == Type::CLV) CLV();
+    else if constexpr (T == Type::CMP) CMP(load<M>(address));
+    else if constexpr (T == Type::CPX) CPX(load<M>(address));
+    else if constexpr (T == Type::CPY) CPY(load<M>(address));
+    else if constexpr (T == Type::DEC) DEC(address);
+    else if constexpr (T == Type::DEX) DEX();
+    else if constexpr (T == Type::DEY) DEY();
+    else if constexpr (T == Type::EOR) EOR(load<M>(address));
+    else if constexpr (T == Type::INC) INC(address);
+    else if constexpr (T == Type::INX) INX();
+    else if constexpr (T == Type::INY) INY();
+    else if constexpr (T == Type::JMP) JMP(address);
+    else if constexpr (T == Type::JSR) JSR(address);
+    else if constexpr (T == Type::LDA) LDA(load<M>(address));
+    else if constexpr (T == Type::LDX) LDX(load<M>(address));
+    else if constexpr (T == Type::LDY) LDY(load<M>(address));
+    else if constexpr (T == Type::LSR) LSR<M>(address);
+    else if constexpr (T == Type::NOP) NOP();
+    else if constexpr (T == Type::ORA) ORA(load<M>(address));
+    else if constexpr (T == Type::PHA) PHA();
+    else if constexpr (T == Type::PHP) PHP();
+    else if constexpr (T == Type::PLA) PLA();
+    else if constexpr (T == Type::PLP) PLP();
+    else if constexpr (T == Type::ROL) ROL<M>(address);
+    else if constexpr (T == Type::ROR) ROR<M>(address);
+    else if constexpr (T == Type::RTI) RTI();
+    else if constexpr (T == Type::RTS) RTS();
+    else if constexpr (T == Type::SBC) SBC(load<M>(address));
+    else if constexpr (T == Type::SEC) SEC();
+    else if constexpr (T == Type::SED) SED();
+    else if constexpr (T == Type::SEI) SEI();
+    else if constexpr (T == Type::STA) STA(address);
+    else if constexpr (T == Type::STX) STX(address);
+    else if constexpr (T == Type::STY) STY(address);
+    else if constexpr (T == Type::TAX) TAX();
+    else if constexpr (T == Type::TAY) TAY();
+    else if constexpr (T == Type::TSX) TSX();
+    else if constexpr (T == Type::TXA) TXA();
+    else if constexpr (T == Type::TXS) TXS();
+    else if constexpr (T == Type::TYA) TYA();
+    //@formatter:on
+}
+
+template<Cpu::AddressingMode M>
+uint16_t Cpu::resolve(uint16_t operand) {
+    using Mode = Cpu::AddressingMode;
+
+    //@formatter:off
+    if constexpr (M == Mode::Implied)          return implied();
+    else if constexpr (M == Mode::Accumulator) return accumulator();
+    else if constexpr (M == Mode::Immediate)   return immediate(operand);
+    else if constexpr (M == Mode::ZeroPage)    return zero_page(operand);
+    else if constexpr (M == Mode::ZeroPageX)   return zero_page_x(operand);
+    else if constexpr (M == Mode::ZeroPageY)   return zero_page_y(operand);
+    else if constexpr (M == Mode::Absolute)    return absolute(operand);
+    else if constexpr (M == Mode::AbsoluteX)   return absolute_x(operand);
+    else if constexpr (M == Mode::AbsoluteY)   return absolute_y(operand);
+    else if constexpr (M == Mode::Indirect)    return indirect(operand);
+    else if constexpr (M == Mode::IndirectX)   return indirect_x(operand);
+    else if constexpr (M == Mode::IndirectY)   return indirect_y(operand);
+    else if constexpr (M == Mode::Relative)    return relative(operand);
+    //@formatter:on
+}
+
+template<Cpu::AddressingMode M>
+uint8_t Cpu::load(uint16_t address) {
+    if constexpr (M == AddressingMode::Immediate) {
+        return address;
+    } else if constexpr (M == AddressingMode::Accumulator) {
+        return a;
+    } else {
+        return read(address);
+    }
+}
+
+template<Cpu::AddressingMode M>
+void Cpu::store(uint16_t address, uint8_t data) {
+    if constexpr (M == AddressingMode::Accumulator) {
+        a = data;
+    } else {
+        write(address, data);
+    }
+}
+
 // Operate directly on one or more registers internal to the CPU.
 // This is for operations like CLC (Clear Carry Flag), TXA (transfer
 // contents of the X-register to the accumulator), etc.
-void Cpu::implied() {
-    current_address = a;
+uint16_t Cpu::implied() {
+    return 0;
 }
 
-// Operate directly on the accumulator. This case is essentially covered
-// with Implied addressing mode, so it may not be needed. TBD.
-void Cpu::accumulator() {
-    // nothing to be done
+// Operate directly on the accumulator (see load() and store()).
+uint16_t Cpu::accumulator() {
+    return 0;
 }
 
 // The second byte of the instruction contains the operand.
-void Cpu::immediate() {
-    current_address = pc++;
+uint16_t Cpu::immediate(uint16_t operand) {
+    return operand;
 }
 
 // Zero page is the first 256 bytes of the CPU's address space (0x00-0xFF).
 // Since the most significant byte of all zero-page addresses are 00, we
 // only need a single byte to specify an address within it.
 // The byte at this address will be the one operated on.
-void Cpu::zero_page() {
-    current_address = read(pc) & 0xFF;
+uint16_t Cpu::zero_page(uint16_t operand) {
+    return operand & 0xFF;
 }
 
 // The same as Zero Page addressing but using the X register as an offset.
-void Cpu::zero_page_x() {
-    current_address = (read(pc) + x) & 0xFF;
+uint16_t Cpu::zero_page_x(uint16_t operand) {
+    return (operand + x) & 0xFF;
 }
 
 // The same as Zero Page addressing but using the Y register as an offset.
-void Cpu::zero_page_y() {
-    current_address = (read(pc) + x) & 0xFF;
+uint16_t Cpu::zero_page_y(uint16_t operand) {
+    return (operand + y) & 0xFF;
 }
 
 // Read a two byte address in the CPU's address space to be operated on.
-void Cpu::absolute() {
-    current_address = read_word(pc);
-    pc += 2;
+uint16_t Cpu::absolute(uint16_t operand) {
+    return operand;
 }
 
 // The same as Absolute addressing but uses the X register as an offset.
 // This mode will take an extra cycle if the page boundary is crossed.
-void Cpu::absolute_x() {
-    uint16_t address = read_word(pc);
-    current_address = address + x;
-    if ((current_address & 0xFF00) != (address & 0xFF00)) {
+uint16_t Cpu::absolute_x(uint16_t operand) {
+    uint16_t address = operand + x;
+    if ((address & 0xFF00) != (operand & 0xFF00)) {
         cycles++;
     }
-    pc += 2;
+    return address;
 }
 
 // The same as Absolute addressing but uses the Y register as an offset.
 // This mode will take an extra cycle if the page boundary is crossed.
-void Cpu::absolute_y() {
-    uint16_t address = read_word(pc);
-    current_address = address + y;
-    if ((current_address & 0xFF00) != (address & 0xFF00)) {
+uint16_t Cpu::absolute_y(uint16_t operand) {
+    uint16_t address = operand + y;
+    if ((address & 0xFF00) != (operand & 0xFF00)) {
         cycles++;
     }
-    pc += 2;
+    return address;
 }
 
 // Uses the contents of the retrieved address as the effective address.
 // These will not overflow into the next page but wrap back around.
-void Cpu::indirect() {
-    uint16_t lo = read(pc++);
-    uint16_t hi = read(pc++);
-
-    uint16_t address = (hi << 8) | lo;
+uint16_t Cpu::indirect(uint16_t operand) {
     // Handle bug where the high byte doesn't change when page boundary
     // is crossed.
-    uint16_t upper = (address & 0x00FF) == 0x00FF ? address & 0xFF00 : address + 1;
-    current_address = read(upper) << 8 | read(address);
+    uint16_t upper = (operand & 0x00FF) == 0x00FF ? operand & 0xFF00 : operand + 1;
+    return read(upper) << 8 | read(operand);
 }
 
 // Similar to Indirect addressing mode but with a single byte address
 // offset by the X register. This will also not overflow but wrap back
 // around.
-void Cpu::indirect_x() {
-    uint8_t address = read(pc++);
-    uint8_t lo = read((address + x) & 0x00FF);
-    uint8_t hi = read((address + x + 1) & 0x00FF);
-    current_address = (hi << 8) | lo;
+uint16_t Cpu::indirect_x(uint16_t operand) {
+    uint8_t lo = read((operand + x) & 0x00FF);
+    uint8_t hi = read((operand + x + 1) & 0x00FF);
+    return (hi << 8) | lo;
 }
 
 // A single byte address indexes a location in the zero page.
 // We add an extra cycle if the page boundary is crossed.
-void Cpu::indirect_y() {
-    uint16_t address = read(pc++);
-    uint16_t lo = read(address & 0x00FF);
-    uint16_t hi = read((address + 1) & 0x00FF) << 8;
-    current_address = (hi | lo) + y;
-    if ((current_address & 0xFF00) != hi) {
+uint16_t Cpu::indirect_y(uint16_t operand) {
+    uint16_t lo = read(operand & 0x00FF);
+    uint16_t hi = read((operand + 1) & 0x00FF) << 8;
+    uint16_t address = (hi | lo) + y;
+    if ((address & 0xFF00) != hi) {
         cycles++;
     }
+    return address;
 }
 
 // Branch instructions can only jump to a "relative" address
 // in the same area (offset between -128 and 127).
-void Cpu::relative() {
+uint16_t Cpu::relative(uint16_t operand) {
     // Using a signed 8-bit integer to keep the range from -128 to 127.
-    int8_t offset = static_cast<int8_t>(read(pc++));
-    current_address = offset + pc;
+    int8_t offset = static_cast<int8_t>(operand);
+    return offset + pc;
 }
 
 // endregion
@@ -221,19 +826,17 @@ void Cpu::relative() {
 // Adds the contents of a memory location to the accumulator
 // together with the carry bit. If overflow occurs the carry bit
 // is set, this enables multiple byte addition to be performed.
-void Cpu::ADC() {
-    uint16_t data = read(current_address);
+void Cpu::ADC(uint8_t data) {
     uint16_t sum = a + data + status.is_set(Flag::Carry);
     status.set_defaults(Flag::Carry | Flag::Zero | Flag::Negative, sum);
-    status.set_if(Flag::Overflow, ((uint16_t) a ^ data) & ((uint16_t) sum ^ data) & 0x80);
+    status.set_overflow((a ^ data) & (sum ^ data));
     a = sum & 0xFF;
 }
 
 // Logical AND
 // A logical AND is performed, bit by bit, on the accumulator
 // contents using the contents of a byte of memory.
-void Cpu::AND() {
-    uint8_t data = read(current_address);
+void Cpu::AND(uint8_t data) {
     a &= data;
     status.set_defaults(Flag::Zero | Flag::Negative, a);
 }
@@ -241,32 +844,33 @@ void Cpu::AND() {
 // Arithmetic Shift Left
 // Shifts all the bits of the accumulator or memory contents one
 // bit left, effectively multiplying by two.
-void Cpu::ASL() {
+template<Cpu::AddressingMode M>
+void Cpu::ASL(uint16_t address) {
     // Read from the current address and shift left.
-    uint16_t data = read(current_address) << 1;
-    write_acc(current_address, data & 0xFF);
+    uint16_t data = load<M>(address) << 1;
+    store<M>(address, data & 0xFF);
     status.set_defaults(Flag::Carry | Flag::Zero | Flag::Negative, data);
 }
 
 // Branch if Carry Clear
 // If the carry flag is clear then add the relative displacement to the
 // program counter to cause a branch to a new location.
-void Cpu::BCC() {
-    branch_if(status.is_clear(Flag::Carry));
+void Cpu::BCC(uint16_t address) {
+    branch_if(status.is_clear(Flag::Carry), address);
 }
 
 // Branch if Carry Set
 // If the carry flag is set then add the relative displacement to the
 // program counter to cause a branch to a new location.
-void Cpu::BCS() {
-    branch_if(status.is_set(Flag::Carry));
+void Cpu::BCS(uint16_t address) {
+    branch_if(status.is_set(Flag::Carry), address);
 }
 
 // Branch if Equal
 // If the zero flag is set then add the relative displacement to the
 // program counter to cause a branch to a new location.
-void Cpu::BEQ() {
-    branch_if(status.is_set(Flag::Zero));
+void Cpu::BEQ(uint16_t address) {
+    branch_if(status.is_set(Flag::Zero), address);
 }
 
 // Bit Test
@@ -274,36 +878,36 @@ void Cpu::BEQ() {
 // The mask pattern in A is ANDed with the value in memory to set or clear
 // the zero flag, but the result is not kept. Bits 7 and 6 of the value
 // from memory are copied into the N and V flags.
-void Cpu::BIT() {
+void Cpu::BIT(uint8_t data) {
     // AND the value in the accumulator with the value in memory.
-    uint8_t data = a & read(current_address);
+    uint8_t result = a & data;
 
     // Copy the 6th bit from the resulting data into the V flag.
-    status.set_if(Flag::Overflow, data & 0x40);
+    status.set_if(Flag::Overflow, result & 0x40);
 
     // Update negative and zero register flags.
-    status.set_defaults(Flag::Negative | Flag::Zero, data);
+    status.set_defaults(Flag::Negative | Flag::Zero, result);
 }
 
 // Branch if Minus
 // If the negative flag is set, then add the relative displacement to the
 // program counter to cause a branch to a new location.
-void Cpu::BMI() {
-    branch_if(status.is_set(Flag::Negative));
+void Cpu::BMI(uint16_t address) {
+    branch_if(status.is_set(Flag::Negative), address);
 }
 
 // Branch if Not Equal
 // If the zero flag is clear then add the relative displacement to the
 // program counter to cause a branch to a new location.
-void Cpu::BNE() {
-    branch_if(status.is_clear(Flag::Zero));
+void Cpu::BNE(uint16_t address) {
+    branch_if(status.is_clear(Flag::Zero), address);
 }
 
 // Branch if Positive
 // If the negative flag is clear then add the relative displacement to the
 // program counter to cause a branch to a new location.
-void Cpu::BPL() {
-    branch_if(status.is_clear(Flag::Negative));
+void Cpu::BPL(uint16_t address) {
+    branch_if(status.is_clear(Flag::Negative), address);
 }
 
 // Force Interrupt
@@ -317,15 +921,15 @@ void Cpu::BRK() {
 // Branch if Overflow Clear
 // If the overflow flag is clear then add the relative displacement to the
 // program counter to cause a branch to a new location.
-void Cpu::BVC() {
-    branch_if(status.is_clear(Flag::Overflow));
+void Cpu::BVC(uint16_t address) {
+    branch_if(status.is_clear(Flag::Overflow), address);
 }
 
 // Branch if Overflow Set
 // If the overflow flag is set then add the relative displacement to the
 // program counter to cause a branch to a new location.
-void Cpu::BVS() {
-    branch_if(status.is_set(Flag::Overflow));
+void Cpu::BVS(uint16_t address) {
+    branch_if(status.is_set(Flag::Overflow), address);
 }
 
 // Clear Carry Flag
@@ -356,30 +960,30 @@ void Cpu::CLV() {
 // Compare
 // Compares the contents of the accumulator with another memory held
 // value and sets the zero and carry flags as appropriate.
-void Cpu::CMP() {
-    compare(a);
+void Cpu::CMP(uint8_t data) {
+    compare(a, data);
 }
 
 // Compare X Register
 // Compares the contents of the X register with another memory held
 // value and sets the zero and carry flags as appropriate.
-void Cpu::CPX() {
-    compare(x);
+void Cpu::CPX(uint8_t data) {
+    compare(x, data);
 }
 
 // Compare Y Register
 // Compares the contents of the Y register with another memory held
 // value and sets the zero and carry flags as appropriate.
-void Cpu::CPY() {
-    compare(y);
+void Cpu::CPY(uint8_t data) {
+    compare(y, data);
 }
 
 // Decrement Memory
 // Subtracts one from the value held at a specified memory location
 // setting the zero and negative flags as appropriate.
-void Cpu::DEC() {
-    uint8_t data = read(current_address) - 1;
-    write(current_address, data);
+void Cpu::DEC(uint16_t address) {
+    uint8_t data = read(address) - 1;
+    write(address, data);
     status.set_defaults(Flag::Zero | Flag::Negative, data);
 }
 
@@ -402,8 +1006,7 @@ void Cpu::DEY() {
 // Exclusive OR
 // An exclusive OR is performed, bit by bit, on the accumulator
 // contents using the contents of a byte of memory.
-void Cpu::EOR() {
-    uint8_t data = read(current_address);
+void Cpu::EOR(uint8_t data) {
     a ^= data;
     status.set_defaults(Flag::Zero | Flag::Negative, a);
 }
@@ -411,9 +1014,9 @@ void Cpu::EOR() {
 // Increment Memory
 // Adds one to the value held at a specified memory location
 // setting the zero and negative flags as appropriate.
-void Cpu::INC() {
-    uint8_t data = read(current_address) + 1;
-    write(current_address, data);
+void Cpu::INC(uint16_t address) {
+    uint8_t data = read(address) + 1;
+    write(address, data);
     status.set_defaults(Flag::Zero | Flag::Negative, data);
 }
 
@@ -435,55 +1038,55 @@ void Cpu::INY() {
 
 // Jump
 // Sets the program counter to the address specified by the operand.
-void Cpu::JMP() {
-    pc = current_address;
+void Cpu::JMP(uint16_t address) {
+    pc = address;
 }
 
 // Jump to Subroutine
 // Pushes the address (minus one) of the return point on to the stack
 // and then sets the program counter to the target memory address.
-void Cpu::JSR() {
-    pc--;
-    stack_push_word(pc);
-    pc = read(pc);
+void Cpu::JSR(uint16_t address) {
+    stack_push_word(pc - 1);
+    pc = address;
 }
 
 // Load Accumulator
 // Loads a byte of memory into the accumulator setting the zero and
 // negative flags as appropriate.
-void Cpu::LDA() {
-    a = read(current_address);
+void Cpu::LDA(uint8_t data) {
+    a = data;
     status.set_defaults(Flag::Zero | Flag::Negative, a);
 }
 
 // Load X Register
 // Loads a byte of memory into the X register setting the zero and
 // negative flags as appropriate.
-void Cpu::LDX() {
-    x = read(current_address);
+void Cpu::LDX(uint8_t data) {
+    x = data;
     status.set_defaults(Flag::Zero | Flag::Negative, x);
 }
 
 // Load Y Register
 // Loads a byte of memory into the Y register setting the zero and
 // negative flags as appropriate.
-void Cpu::LDY() {
-    y = read(current_address);
+void Cpu::LDY(uint8_t data) {
+    y = data;
     status.set_defaults(Flag::Zero | Flag::Negative, y);
 }
 
 // Logical Shift Right
 // Each of the bits in A or M is shift one place to the right. The bit that
 // was in bit 0 is shifted into the carry flag. Bit 7 is set to zero.
-void Cpu::LSR() {
-    uint8_t data = read(current_address);
+template<Cpu::AddressingMode M>
+void Cpu::LSR(uint16_t address) {
+    uint8_t data = load<M>(address);
 
     // Set the Carry flag to the value in the first bit before shifting.
     status.set_if(StatusRegister::Carry, data & 0x1);
 
     data >>= 1;
     status.set_defaults(Flag::Zero | Flag::Negative, data);
-    write_acc(current_address, data);
+    store<M>(address, data);
 }
 
 // No Operation
@@ -496,8 +1099,7 @@ void Cpu::NOP() {
 // Logical Inclusive OR
 // An inclusive OR is performed, bit by bit, on the accumulator
 // contents using the contents of a byte of memory.
-void Cpu::ORA() {
-    uint8_t data = read(current_address);
+void Cpu::ORA(uint8_t data) {
     a |= data;
     status.set_defaults(Flag::Zero | Flag::Negative, a);
 }
@@ -536,23 +1138,25 @@ void Cpu::PLP() {
 // Move each of the bits in either A or M one place to the left. Bit 0 is
 // filled with the current value of the carry flag whilst the old bit 7
 // becomes the new carry flag value.
-void Cpu::ROL() {
-    uint16_t data = read(current_address);
+template<Cpu::AddressingMode M>
+void Cpu::ROL(uint16_t address) {
+    uint16_t data = load<M>(address);
     data = (data << 1) | status.is_set(Flag::Carry);
     status.set_defaults(Flag::Carry | Flag::Zero | Flag::Negative, data);
-    write_acc(current_address, data & 0xFF);
+    store<M>(address, data & 0xFF);
 }
 
 // Rotate Right
 // Move each of the bits in either A or M one place to the right. Bit 7 is
 // filled with the current value of the carry flag whilst the old bit 0
 // becomes the new carry flag value.
-void Cpu::ROR() {
-    uint8_t data = read(current_address);
-    uint8_t shifted = status.is_set(Flag::Carry) << 7 | (data >> 7);
+template<Cpu::AddressingMode M>
+void Cpu::ROR(uint16_t address) {
+    uint8_t data = load<M>(address);
+    uint8_t shifted = status.is_set(Flag::Carry) << 7 | (data >> 1);
     status.set_if(Flag::Carry, data & 0x01);
     status.set_defaults(Flag::Zero | Flag::Negative, shifted);
-    write_acc(current_address, shifted);
+    store<M>(address, shifted);
 }
 
 // Return from Interrupt
@@ -581,11 +1185,11 @@ void Cpu::RTS() {
 // Subtracts the contents of a memory location to the accumulator
 // together with the not of the carry bit. If overflow occurs the carry
 // bit is clear, this enables multiple byte subtraction to be performed.
-void Cpu::SBC() {
-    uint16_t data = ((uint16_t) read(current_address)) ^ 0x00FF;
+void Cpu::SBC(uint8_t value) {
+    uint16_t data = ((uint16_t) value) ^ 0x00FF;
     uint16_t diff = a + data + status.is_set(Flag::Carry);
     status.set_defaults(Flag::Carry | Flag::Zero | Flag::Negative, diff);
-    status.set_if(Flag::Overflow, (diff ^ a) & (diff ^ data) & 0x80);
+    status.set_overflow((diff ^ a) & (diff ^ data));
     a = diff & 0xFF;
 }
 
@@ -606,20 +1210,20 @@ void Cpu::SEI() {
 
 // Store Accumulator
 // Stores the contents of the accumulator into memory.
-void Cpu::STA() {
-    write(current_address, a);
+void Cpu::STA(uint16_t address) {
+    write(address, a);
 }
 
 // Store X Register
 // Stores the contents of the X register into memory.
-void Cpu::STX() {
-    write(current_address, x);
+void Cpu::STX(uint16_t address) {
+    write(address, x);
 }
 
 // Store Y Register
 // Stores the contents of the Y register into memory.
-void Cpu::STY() {
-    write(current_address, y);
+void Cpu::STY(uint16_t address) {
+    write(address, y);
 }
 
 // Transfer Accumulator to X
@@ -675,7 +1279,7 @@ void Cpu::TYA() {
 
 // Convenience method for branching instructions (e.g. BCS, BCC, BNE).
 // Performs the branching operation if the condition is met.
-void Cpu::branch_if(bool condition) {
+void Cpu::branch_if(bool condition, uint16_t address) {
     if (!condition) {
         return;
     }
@@ -684,21 +1288,20 @@ void Cpu::branch_if(bool condition) {
     cycles++;
 
     // Add another cycle if a page boundary was crossed.
-    if ((current_address & 0xFF00) != (pc & 0xFF00)) {
+    if ((address & 0xFF00) != (pc & 0xFF00)) {
         cycles++;
     }
 
-    // The current address has already been offset due
-    // to relative addressing (see relative()), we just
-    // need to assign it to the program counter.
-    pc = current_address;
+    // The address has already been offset due to relative
+    // addressing (see relative()), we just need to assign
+    // it to the program counter.
+    pc = address;
 }
 
 // Convenience method for compare instructions (e.g. CMP, CPX, CPY).
 // Compares the data read from memory with the value in the specified
 // register and sets the Carry, Zero, and Negative flags appropriately.
-void Cpu::compare(uint8_t _register) {
-    uint8_t data = read(current_address);
+void Cpu::compare(uint8_t _register, uint8_t data) {
     status.set_if(Flag::Carry, _register >= data);
 
     uint8_t diff = _register - data;
@@ -754,12 +1357,14 @@ void Cpu::interrupt(Cpu::InterruptType type) {
     // Push the current program counter on the stack
     stack_push_word(pc);
 
-    // Set the I flag and set the B flag if it's a BRK (software) interrupt
-    status.set(Flag::InterruptDisable | Flag::Unused);
+    // Set the B flag if it's a BRK (software) interrupt
+    status.set(Flag::Unused);
     status.set_if(Flag::Break, type == InterruptType::BRK);
 
-    // Save the state of the status register onto the stack
+    // Save the state of the status register onto the stack, before setting
+    // the I flag so that RTI lets interrupts back in.
     stack_push(status.get_value());
+    status.set(Flag::InterruptDisable);
 
     // The interrupt vector for NMI is 0xFFFA and 0xFFFE for BRK and IRQ.
     uint16_t vector = type == InterruptType::NMI ? 0xFFFA : 0xFFFE;
@@ -775,271 +1380,9 @@ void Cpu::interrupt(Cpu::InterruptType type) {
 
 // region Initialization and Debug Methods
 
-// Initializes the mappings for all instructions.
-// See https://www.masswerk.at/6502/6502_instruction_set.html
+// Initializes the CPU. The instruction lookup table is built at compile
+// time from CPU_OPCODES, so all that's left is to reset the CPU.
 void Cpu::initialize() {
-    using Type = Cpu::InstructionType;
-    using Mode = Cpu::AddressingMode;
-    //@formatter:off
-    instructions = {
-            { 0x00, Type::BRK, Mode::Implied,     &Cpu::BRK, &Cpu::implied,     1, 0 }, // Setting BRK cycles to 0 here,
-            { 0x01, Type::ORA, Mode::IndirectX,   &Cpu::ORA, &Cpu::indirect_x,  2, 6 }, // even though it's actually 7.
-            { 0x02, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 }, // It is handled in the interrupt method.
-            { 0x03, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x04, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x05, Type::ORA, Mode::ZeroPage,    &Cpu::ORA, &Cpu::zero_page,   2, 3 },
-            { 0x06, Type::ASL, Mode::ZeroPage,    &Cpu::ASL, &Cpu::zero_page,   2, 5 },
-            { 0x07, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x08, Type::PHP, Mode::Implied,     &Cpu::PHP, &Cpu::implied,     1, 3 },
-            { 0x09, Type::ORA, Mode::Immediate,   &Cpu::ORA, &Cpu::immediate,   2, 2 },
-            { 0x0A, Type::ASL, Mode::Accumulator, &Cpu::ASL, &Cpu::accumulator, 1, 2 },
-            { 0x0B, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x0C, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x0D, Type::ORA, Mode::Absolute,    &Cpu::ORA, &Cpu::absolute,    3, 4 },
-            { 0x0E, Type::ASL, Mode::Absolute,    &Cpu::ASL, &Cpu::absolute,    3, 6 },
-            { 0x0F, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x10, Type::BPL, Mode::Relative,    &Cpu::BPL, &Cpu::relative,    2, 2 },
-            { 0x11, Type::ORA, Mode::IndirectY,   &Cpu::ORA, &Cpu::indirect_y,  2, 5 },
-            { 0x12, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x13, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x14, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x15, Type::ORA, Mode::ZeroPageX,   &Cpu::ORA, &Cpu::zero_page_x, 2, 4 },
-            { 0x16, Type::ASL, Mode::ZeroPageX,   &Cpu::ASL, &Cpu::zero_page_x, 2, 6 },
-            { 0x17, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x18, Type::CLC, Mode::Implied,     &Cpu::CLC, &Cpu::implied,     1, 2 },
-            { 0x19, Type::ORA, Mode::AbsoluteY,   &Cpu::ORA, &Cpu::absolute_y,  3, 4 },
-            { 0x1A, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x1B, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x1C, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x1D, Type::ORA, Mode::AbsoluteX,   &Cpu::ORA, &Cpu::absolute_x,  3, 4 },
-            { 0x1E, Type::ASL, Mode::AbsoluteX,   &Cpu::ASL, &Cpu::absolute_x,  3, 7 },
-            { 0x1F, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x20, Type::JSR, Mode::Absolute,    &Cpu::JSR, &Cpu::absolute,    3, 6 },
-            { 0x21, Type::AND, Mode::IndirectX,   &Cpu::AND, &Cpu::indirect_x,  2, 6 },
-            { 0x22, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x23, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x24, Type::BIT, Mode::ZeroPage,    &Cpu::BIT, &Cpu::zero_page,   2, 3 },
-            { 0x25, Type::AND, Mode::ZeroPage,    &Cpu::AND, &Cpu::zero_page,   2, 3 },
-            { 0x26, Type::ROL, Mode::ZeroPage,    &Cpu::ROL, &Cpu::zero_page,   2, 5 },
-            { 0x27, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x28, Type::PLP, Mode::Implied,     &Cpu::PLP, &Cpu::implied,     1, 4 },
-            { 0x29, Type::AND, Mode::Immediate,   &Cpu::AND, &Cpu::immediate,   2, 2 },
-            { 0x2A, Type::ROL, Mode::Accumulator, &Cpu::ROL, &Cpu::accumulator, 1, 2 },
-            { 0x2B, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x2C, Type::BIT, Mode::Absolute,    &Cpu::BIT, &Cpu::absolute,    3, 4 },
-            { 0x2D, Type::AND, Mode::Absolute,    &Cpu::AND, &Cpu::absolute,    3, 4 },
-            { 0x2E, Type::ROL, Mode::Absolute,    &Cpu::ROL, &Cpu::absolute,    3, 6 },
-            { 0x2F, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x30, Type::BMI, Mode::Relative,    &Cpu::BMI, &Cpu::relative,    2, 2 },
-            { 0x31, Type::AND, Mode::IndirectY,   &Cpu::AND, &Cpu::indirect_y,  2, 5 },
-            { 0x32, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x33, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x34, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x35, Type::AND, Mode::ZeroPageX,   &Cpu::AND, &Cpu::zero_page_x, 2, 4 },
-            { 0x36, Type::ROL, Mode::ZeroPageX,   &Cpu::ROL, &Cpu::zero_page_x, 2, 6 },
-            { 0x37, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x38, Type::SEC, Mode::Implied,     &Cpu::SEC, &Cpu::implied,     1, 2 },
-            { 0x39, Type::AND, Mode::AbsoluteY,   &Cpu::AND, &Cpu::absolute_y,  3, 4 },
-            { 0x3A, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x3B, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x3C, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x3D, Type::AND, Mode::AbsoluteX,   &Cpu::AND, &Cpu::absolute_x,  3, 4 },
-            { 0x3E, Type::ROL, Mode::AbsoluteX,   &Cpu::ROL, &Cpu::absolute_x,  3, 7 },
-            { 0x3F, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x40, Type::RTI, Mode::Implied,     &Cpu::RTI, &Cpu::implied,     1, 6 },
-            { 0x41, Type::EOR, Mode::IndirectX,   &Cpu::EOR, &Cpu::indirect_x,  2, 6 },
-            { 0x42, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x43, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x44, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x45, Type::EOR, Mode::ZeroPage,    &Cpu::EOR, &Cpu::zero_page,   2, 3 },
-            { 0x46, Type::LSR, Mode::ZeroPage,    &Cpu::LSR, &Cpu::zero_page,   2, 5 },
-            { 0x47, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x48, Type::PHA, Mode::Implied,     &Cpu::PHA, &Cpu::implied,     1, 3 },
-            { 0x49, Type::EOR, Mode::Immediate,   &Cpu::EOR, &Cpu::immediate,   2, 2 },
-            { 0x4A, Type::LSR, Mode::Accumulator, &Cpu::LSR, &Cpu::accumulator, 1, 2 },
-            { 0x4B, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x4C, Type::JMP, Mode::Absolute,    &Cpu::JMP, &Cpu::absolute,    3, 3 },
-            { 0x4D, Type::EOR, Mode::Absolute,    &Cpu::EOR, &Cpu::absolute,    3, 4 },
-            { 0x4E, Type::LSR, Mode::Absolute,    &Cpu::LSR, &Cpu::absolute,    3, 6 },
-            { 0x4F, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x50, Type::BVC, Mode::Relative,    &Cpu::BVC, &Cpu::relative,    2, 2 },
-            { 0x51, Type::EOR, Mode::IndirectY,   &Cpu::EOR, &Cpu::indirect_y,  2, 5 },
-            { 0x52, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x53, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x54, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x55, Type::EOR, Mode::ZeroPageX,   &Cpu::EOR, &Cpu::zero_page_x, 2, 4 },
-            { 0x56, Type::LSR, Mode::ZeroPageX,   &Cpu::LSR, &Cpu::zero_page_x, 2, 6 },
-            { 0x57, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x58, Type::CLI, Mode::Implied,     &Cpu::CLI, &Cpu::implied,     1, 2 },
-            { 0x59, Type::EOR, Mode::AbsoluteY,   &Cpu::EOR, &Cpu::absolute_y,  3, 4 },
-            { 0x5A, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x5B, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x5C, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x5D, Type::EOR, Mode::AbsoluteX,   &Cpu::EOR, &Cpu::absolute_x,  3, 4 },
-            { 0x5E, Type::LSR, Mode::AbsoluteX,   &Cpu::LSR, &Cpu::absolute_x,  3, 7 },
-            { 0x5F, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x60, Type::RTS, Mode::Implied,     &Cpu::RTS, &Cpu::implied,     1, 6 },
-            { 0x61, Type::ADC, Mode::IndirectX,   &Cpu::ADC, &Cpu::indirect_x,  2, 6 },
-            { 0x62, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x63, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x64, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x65, Type::ADC, Mode::ZeroPage,    &Cpu::ADC, &Cpu::zero_page,   2, 3 },
-            { 0x66, Type::ROR, Mode::ZeroPage,    &Cpu::ROR, &Cpu::zero_page,   2, 5 },
-            { 0x67, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x68, Type::PLA, Mode::Implied,     &Cpu::PLA, &Cpu::implied,     1, 4 },
-            { 0x69, Type::ADC, Mode::Immediate,   &Cpu::ADC, &Cpu::immediate,   2, 2 },
-            { 0x6A, Type::ROR, Mode::Accumulator, &Cpu::ROR, &Cpu::accumulator, 1, 2 },
-            { 0x6B, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x6C, Type::JMP, Mode::Indirect,    &Cpu::JMP, &Cpu::indirect,    3, 5 },
-            { 0x6D, Type::ADC, Mode::Absolute,    &Cpu::ADC, &Cpu::absolute,    3, 4 },
-            { 0x6E, Type::ROR, Mode::Absolute,    &Cpu::ROR, &Cpu::absolute,    3, 6 },
-            { 0x6F, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x70, Type::BVS, Mode::Relative,    &Cpu::BVS, &Cpu::relative,    2, 2 },
-            { 0x71, Type::ADC, Mode::IndirectY,   &Cpu::ADC, &Cpu::indirect_y,  2, 5 },
-            { 0x72, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x73, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x74, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x75, Type::ADC, Mode::ZeroPageX,   &Cpu::ADC, &Cpu::zero_page_x, 2, 4 },
-            { 0x76, Type::ROR, Mode::ZeroPageX,   &Cpu::ROR, &Cpu::zero_page_x, 2, 6 },
-            { 0x77, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x78, Type::SEI, Mode::Implied,     &Cpu::SEI, &Cpu::implied,     1, 2 },
-            { 0x79, Type::ADC, Mode::AbsoluteY,   &Cpu::ADC, &Cpu::absolute_y,  3, 4 },
-            { 0x7A, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x7B, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x7C, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x7D, Type::ADC, Mode::AbsoluteX,   &Cpu::ADC, &Cpu::absolute_x,  3, 4 },
-            { 0x7E, Type::ROR, Mode::AbsoluteX,   &Cpu::ROR, &Cpu::absolute_x,  3, 7 },
-            { 0x7F, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x80, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x81, Type::STA, Mode::IndirectX,   &Cpu::STA, &Cpu::indirect_x,  2, 6 },
-            { 0x82, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x83, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x84, Type::STY, Mode::ZeroPage,    &Cpu::STY, &Cpu::zero_page,   2, 3 },
-            { 0x85, Type::STA, Mode::ZeroPage,    &Cpu::STA, &Cpu::zero_page,   2, 3 },
-            { 0x86, Type::STX, Mode::ZeroPage,    &Cpu::STX, &Cpu::zero_page,   2, 3 },
-            { 0x87, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x88, Type::DEY, Mode::Implied,     &Cpu::DEY, &Cpu::implied,     1, 2 },
-            { 0x89, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x8A, Type::TXA, Mode::Implied,     &Cpu::TXA, &Cpu::implied,     1, 2 },
-            { 0x8B, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x8C, Type::STY, Mode::Absolute,    &Cpu::STY, &Cpu::absolute,    3, 4 },
-            { 0x8D, Type::STA, Mode::Absolute,    &Cpu::STA, &Cpu::absolute,    3, 4 },
-            { 0x8E, Type::STX, Mode::Absolute,    &Cpu::STX, &Cpu::absolute,    3, 4 },
-            { 0x8F, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x90, Type::BCC, Mode::Relative,    &Cpu::BCC, &Cpu::relative,    2, 2 },
-            { 0x91, Type::STA, Mode::IndirectY,   &Cpu::STA, &Cpu::indirect_y,  2, 6 },
-            { 0x92, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x93, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x94, Type::STY, Mode::ZeroPageY,   &Cpu::STY, &Cpu::zero_page_y, 2, 4 },
-            { 0x95, Type::STA, Mode::ZeroPageX,   &Cpu::STA, &Cpu::zero_page_x, 2, 4 },
-            { 0x96, Type::STX, Mode::ZeroPageY,   &Cpu::STX, &Cpu::zero_page_y, 2, 4 },
-            { 0x97, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x98, Type::TYA, Mode::Implied,     &Cpu::TYA, &Cpu::implied,     1, 2 },
-            { 0x99, Type::STA, Mode::AbsoluteY,   &Cpu::STA, &Cpu::absolute_y,  3, 5 },
-            { 0x9A, Type::TXS, Mode::Implied,     &Cpu::TXS, &Cpu::implied,     1, 2 },
-            { 0x9B, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x9C, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x9D, Type::STA, Mode::AbsoluteX,   &Cpu::STA, &Cpu::absolute_x,  3, 5 },
-            { 0x9E, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x9F, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xA0, Type::LDY, Mode::Immediate,   &Cpu::LDY, &Cpu::immediate,   2, 2 },
-            { 0xA1, Type::LDA, Mode::IndirectX,   &Cpu::LDA, &Cpu::indirect_x,  2, 6 },
-            { 0xA2, Type::LDX, Mode::Immediate,   &Cpu::LDX, &Cpu::immediate,   2, 2 },
-            { 0xA3, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xA4, Type::LDY, Mode::ZeroPage,    &Cpu::LDY, &Cpu::zero_page,   2, 3 },
-            { 0xA5, Type::LDA, Mode::ZeroPage,    &Cpu::LDA, &Cpu::zero_page,   2, 3 },
-            { 0xA6, Type::LDX, Mode::ZeroPage,    &Cpu::LDX, &Cpu::zero_page,   2, 3 },
-            { 0xA7, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xA8, Type::TAY, Mode::Implied,     &Cpu::TAY, &Cpu::implied,     1, 2 },
-            { 0xA9, Type::LDA, Mode::Immediate,   &Cpu::LDA, &Cpu::immediate,   2, 2 },
-            { 0xAA, Type::TAX, Mode::Implied,     &Cpu::TAX, &Cpu::implied,     1, 2 },
-            { 0xAB, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xAC, Type::LDY, Mode::Absolute,    &Cpu::LDY, &Cpu::absolute,    3, 4 },
-            { 0xAD, Type::LDA, Mode::Absolute,    &Cpu::LDA, &Cpu::absolute,    3, 4 },
-            { 0xAE, Type::LDX, Mode::Absolute,    &Cpu::LDX, &Cpu::absolute,    3, 4 },
-            { 0xAF, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xB0, Type::BCS, Mode::Relative,    &Cpu::BCS, &Cpu::relative,    2, 2 },
-            { 0xB1, Type::LDA, Mode::IndirectY,   &Cpu::LDA, &Cpu::indirect_y,  2, 5 },
-            { 0x82, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0x83, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xB4, Type::LDY, Mode::ZeroPageX,   &Cpu::LDY, &Cpu::zero_page_x, 2, 4 },
-            { 0xB5, Type::LDA, Mode::ZeroPageX,   &Cpu::LDA, &Cpu::zero_page_x, 2, 4 },
-            { 0xB6, Type::LDX, Mode::ZeroPageY,   &Cpu::LDX, &Cpu::zero_page_y, 2, 4 },
-            { 0x87, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xB8, Type::CLV, Mode::Implied,     &Cpu::CLV, &Cpu::implied,     1, 2 },
-            { 0xB9, Type::LDA, Mode::AbsoluteY,   &Cpu::LDA, &Cpu::absolute_y,  3, 4 },
-            { 0xBA, Type::TSX, Mode::Implied,     &Cpu::TSX, &Cpu::implied,     1, 2 },
-            { 0xBB, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xBC, Type::LDY, Mode::AbsoluteX,   &Cpu::LDY, &Cpu::absolute_x,  3, 4 },
-            { 0xBD, Type::LDA, Mode::AbsoluteX,   &Cpu::LDA, &Cpu::absolute_x,  3, 4 },
-            { 0xBE, Type::LDX, Mode::AbsoluteY,   &Cpu::LDX, &Cpu::absolute_y,  3, 4 },
-            { 0xBF, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xC0, Type::CPY, Mode::Immediate,   &Cpu::CPY, &Cpu::immediate,   2, 2 },
-            { 0xC1, Type::CMP, Mode::IndirectX,   &Cpu::CMP, &Cpu::indirect_x,  2, 6 },
-            { 0xC2, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xC3, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xC4, Type::CPY, Mode::ZeroPage,    &Cpu::CPY, &Cpu::zero_page,   2, 3 },
-            { 0xC5, Type::CMP, Mode::ZeroPage,    &Cpu::CMP, &Cpu::zero_page,   2, 3 },
-            { 0xC6, Type::DEC, Mode::ZeroPage,    &Cpu::DEC, &Cpu::zero_page,   2, 5 },
-            { 0xC7, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xC8, Type::INY, Mode::Implied,     &Cpu::INY, &Cpu::implied,     1, 2 },
-            { 0xC9, Type::CMP, Mode::Immediate,   &Cpu::CMP, &Cpu::immediate,   2, 2 },
-            { 0xCA, Type::DEX, Mode::Implied,     &Cpu::DEX, &Cpu::implied,     1, 2 },
-            { 0xCB, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xCC, Type::CPY, Mode::Absolute,    &Cpu::CPY, &Cpu::absolute,    3, 4 },
-            { 0xCD, Type::CMP, Mode::Absolute,    &Cpu::CMP, &Cpu::absolute,    3, 4 },
-            { 0xCE, Type::DEC, Mode::Absolute,    &Cpu::DEC, &Cpu::absolute,    3, 6 },
-            { 0xCF, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xD0, Type::BNE, Mode::Relative,    &Cpu::BNE, &Cpu::relative,    2, 2 },
-            { 0xD1, Type::CMP, Mode::IndirectY,   &Cpu::CMP, &Cpu::indirect_y,  2, 5 },
-            { 0xD2, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xD3, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xD4, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xD5, Type::CMP, Mode::ZeroPageX,   &Cpu::CMP, &Cpu::zero_page_x, 2, 4 },
-            { 0xD6, Type::DEC, Mode::ZeroPageX,   &Cpu::DEC, &Cpu::zero_page_x, 2, 6 },
-            { 0xD7, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xD8, Type::CLD, Mode::Implied,     &Cpu::CLD, &Cpu::implied,     1, 2 },
-            { 0xD9, Type::CMP, Mode::AbsoluteY,   &Cpu::CMP, &Cpu::absolute_y,  3, 4 },
-            { 0xDA, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xDB, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xDC, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xDD, Type::CMP, Mode::AbsoluteX,   &Cpu::CMP, &Cpu::absolute_x,  3, 4 },
-            { 0xDE, Type::DEC, Mode::AbsoluteX,   &Cpu::DEC, &Cpu::absolute_x,  3, 7 },
-            { 0xDF, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xE0, Type::CPX, Mode::Immediate,   &Cpu::CPX, &Cpu::immediate,   2, 2 },
-            { 0xE1, Type::SBC, Mode::IndirectX,   &Cpu::SBC, &Cpu::indirect_x,  2, 6 },
-            { 0xE2, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xE3, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xE4, Type::CPX, Mode::ZeroPage,    &Cpu::CPX, &Cpu::zero_page,   2, 3 },
-            { 0xE5, Type::SBC, Mode::ZeroPage,    &Cpu::SBC, &Cpu::zero_page,   2, 3 },
-            { 0xE6, Type::INC, Mode::ZeroPage,    &Cpu::INC, &Cpu::zero_page,   2, 5 },
-            { 0xE7, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xE8, Type::INX, Mode::Implied,     &Cpu::INX, &Cpu::implied,     1, 2 },
-            { 0xE9, Type::SBC, Mode::Immediate,   &Cpu::SBC, &Cpu::immediate,   2, 2 },
-            { 0xEA, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xEB, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xEC, Type::CPX, Mode::Absolute,    &Cpu::CPX, &Cpu::absolute,    3, 4 },
-            { 0xED, Type::SBC, Mode::Absolute,    &Cpu::SBC, &Cpu::absolute,    3, 4 },
-            { 0xEE, Type::INC, Mode::Absolute,    &Cpu::INC, &Cpu::absolute,    3, 6 },
-            { 0xEF, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xF0, Type::BEQ, Mode::Relative,    &Cpu::BEQ, &Cpu::relative,    2, 2 },
-            { 0xF1, Type::SBC, Mode::IndirectY,   &Cpu::SBC, &Cpu::indirect_y,  2, 5 },
-            { 0xF2, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xF3, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xF4, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xF5, Type::SBC, Mode::ZeroPageX,   &Cpu::SBC, &Cpu::zero_page_x, 2, 4 },
-            { 0xF6, Type::INC, Mode::ZeroPageX,   &Cpu::INC, &Cpu::zero_page_x, 2, 6 },
-            { 0xF7, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xF8, Type::SED, Mode::Implied,     &Cpu::SED, &Cpu::implied,     1, 2 },
-            { 0xF9, Type::SBC, Mode::AbsoluteY,   &Cpu::SBC, &Cpu::absolute_y,  3, 4 },
-            { 0xFA, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xFB, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xFC, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-            { 0xFD, Type::SBC, Mode::AbsoluteX,   &Cpu::SBC, &Cpu::absolute_x,  3, 4 },
-            { 0xFE, Type::INC, Mode::AbsoluteX,   &Cpu::INC, &Cpu::absolute_x,  3, 7 },
-            { 0xFF, Type::NOP, Mode::Implied,     &Cpu::NOP, &Cpu::implied,     1, 2 },
-    };
-    //@formatter:on
     reset();
 }
 
@@ -2,9 +2,11 @@
 #define NES_CPU_H
 
 
+#include <array>
+#include <bitset>
 #include <cstdint>
 #include <string>
-#include <vector>
+#include "block_cache.h"
 #include "registers/status.h"
 
 class Bus;
@@ -15,17 +17,38 @@ public:
 
     void initialize();
     void cycle();
+    // Run whole instructions until the total cycle count reaches the target
+    // cycle, returning the number of cycles the last instruction overshot it.
+    // The target must not be later than the next event that could change
+    // what the CPU reads (vblank, an NMI, a sprite 0 hit, etc.), since idle
+    // loops waiting on those are skipped straight to the target.
+    uint64_t run_until(uint64_t target_cycle);
+    // Stop running the current cached block after this instruction. The bus
+    // calls this when the memory map changes underneath the CPU.
+    void end_block();
+    // Return from run_until() after the current instruction, so the bus can
+    // deliver an interrupt that was raised part way through a run.
+    void stop();
+    // Add cycles to the instruction being executed, for when something else
+    // holds the CPU off the bus (e.g. OAM DMA).
+    void stall(uint16_t stall_cycles);
+    // The cycle the memory access being made right now happens on. Accesses
+    // are counted as happening on the last cycle of their instruction.
+    [[nodiscard]] uint64_t get_cycle() const;
+    [[nodiscard]] uint64_t get_total_cycles() const { return total_cycles; }
     void reset();
     void nmi();
     void irq();
+    // Whether an IRQ would be ignored right now (the I flag is set).
+    [[nodiscard]] bool is_irq_masked() const { return status.is_set(StatusRegister::InterruptDisable); }
 
-    enum class InstructionType {
+    enum class InstructionType : uint8_t {
         ADC, AND, ASL, BCC, BCS, BEQ, BIT, BMI, BNE, BPL, BRK, BVC, BVS, CLC,
         CLD, CLI, CLV, CMP, CPX, CPY, DEC, DEX, DEY, EOR, INC, INX, INY, JMP,
         JSR, LDA, LDX, LDY, LSR, NOP, ORA, PHA, PHP, PLA, PLP, ROL, ROR, RTI,
         RTS, SBC, SEC, SED, SEI, STA, STX, STY, TAX, TAY, TSX, TXA, TXS, TYA
     };
-    enum class AddressingMode {
+    enum class AddressingMode : uint8_t {
         Implied, Accumulator, Immediate, ZeroPage, ZeroPageX, ZeroPageY,
         Absolute, AbsoluteX, AbsoluteY, Indirect, IndirectX, IndirectY, Relative,
     };
@@ -39,8 +62,6 @@ public:
         uint8_t opcode;
         InstructionType type;
         AddressingMode mode;
-        void (Cpu::*ref_operation)();
-        void (Cpu::*ref_mode)();
         uint8_t bytes;
         uint8_t cycles;
     };
@@ -54,20 +75,60 @@ protected: // Protected to allow access for unit testing
     uint8_t sp;       // stack pointer
     uint16_t cycles;  // current cycles
     StatusRegister status; // status register (P)
-    uint32_t total_cycles; // total clock cycles
+    uint64_t total_cycles; // total clock cycles
 
     uint16_t current_address; // current address
     Instruction current_instruction; // current instruction
-    std::vector<Instruction> instructions; // instruction lookup table
+    static const std::array<Instruction, 256> instructions; // instruction lookup table
+
+    // Execute a single instruction and return the number of cycles it took.
+    uint16_t step();
+
+    // run_until() executes decoded basic blocks out of this cache instead of
+    // fetching and decoding every instruction through the bus. It can be
+    // turned off when memory accesses don't go through the bus (in tests).
+    bool cache_blocks = true;
+    BlockCache blocks;
+    std::bitset<256> code_pages; // writable pages we've decoded code from
+    bool block_ended = false;
+    bool stopped = false;
+
+    // Find the cached block at the address, decoding it if it isn't cached
+    // yet. Returns nullptr if the code there can't be cached.
+    const BasicBlock *find_block(uint16_t address);
+    const BasicBlock *decode_block(uint16_t address, const uint8_t *code);
+    void run_block(const BasicBlock &block, uint64_t target_cycle);
+    void run_idle_loop(const BasicBlock &block, uint64_t target_cycle);
+    bool is_idle_loop(const BasicBlock &block, uint16_t address);
+
+    // Execute the handler for an opcode with its already fetched operand bytes.
+    void dispatch(uint8_t opcode, uint16_t operand);
+
+    // The handler for a single opcode, generated from its instruction and
+    // addressing mode so that each opcode gets its own fused, inlined code.
+    template<InstructionType T, AddressingMode M>
+    void execute(uint16_t operand);
+
+    // Resolve the effective address for an addressing mode. For immediate
+    // mode this is the operand itself.
+    template<AddressingMode M>
+    uint16_t resolve(uint16_t operand);
+
+    // Load the value an instruction operates on (memory, the accumulator,
+    // or the immediate operand).
+    template<AddressingMode M>
+    uint8_t load(uint16_t address);
+
+    // Store the result of a read-modify-write instruction (memory or the
+    // accumulator).
+    template<AddressingMode M>
+    void store(uint16_t address, uint8_t data);
 
     // the main bus and methods for communicating with other components
     Bus *bus;
     virtual uint8_t read(uint16_t address);
     uint16_t read_word(uint16_t address);
     virtual void write(uint16_t address, uint8_t data);
-    // same as write, except writes to the accumulator instead
-    // of memory if the current addressing mode is accumulator.
-    void write_acc(uint16_t address, uint8_t data);
     void stack_push(uint8_t data);
     void stack_push_word(uint16_t data);
     uint8_t stack_pop();
@@ -76,56 +137,56 @@ protected: // Protected to allow access for unit testing
     std::string get_addressing_mode_name(AddressingMode mode);
 
     //region instructions
-    void ADC();
-    void AND();
-    void ASL();
-    void BCC();
-    void BCS();
-    void BEQ();
-    void BIT();
-    void BMI();
-    void BNE();
-    void BPL();
+    void ADC(uint8_t data);
+    void AND(uint8_t data);
+    template<AddressingMode M> void ASL(uint16_t address);
+    void BCC(uint16_t address);
+    void BCS(uint16_t address);
+    void BEQ(uint16_t address);
+    void BIT(uint8_t data);
+    void BMI(uint16_t address);
+    void BNE(uint16_t address);
+    void BPL(uint16_t address);
     void BRK();
-    void BVC();
-    void BVS();
+    void BVC(uint16_t address);
+    void BVS(uint16_t address);
     void CLC();
     void CLD();
     void CLI();
     void CLV();
-    void CMP();
-    void CPX();
-    void CPY();
-    void DEC();
+    void CMP(uint8_t data);
+    void CPX(uint8_t data);
+    void CPY(uint8_t data);
+    void DEC(uint16_t address);
     void DEX();
     void DEY();
-    void EOR();
-    void INC();
+    void EOR(uint8_t data);
+    void INC(uint16_t address);
     void INX();
     void INY();
-    void JMP();
-    void JSR();
-    void LDA();
-    void LDX();
-    void LDY();
-    void LSR();
+    void JMP(uint16_t address);
+    void JSR(uint16_t address);
+    void LDA(uint8_t data);
+    void LDX(uint8_t data);
+    void LDY(uint8_t data);
+    template<AddressingMode M> void LSR(uint16_t address);
     void NOP();
-    void ORA();
+    void ORA(uint8_t data);
     void PHA();
     void PHP();
     void PLA();
     void PLP();
-    void ROL();
-    void ROR();
+    template<AddressingMode M> void ROL(uint16_t address);
+    template<AddressingMode M> void ROR(uint16_t address);
     void RTI();
     void RTS();
-    void SBC();
+    void SBC(uint8_t data);
     void SEC();
     void SED();
     void SEI();
-    void STA();
-    void STX();
-    void STY();
+    void STA(uint16_t address);
+    void STX(uint16_t address);
+    void STY(uint16_t address);
     void TAX();
     void TAY();
     void TSX();
@@ -134,10 +195,10 @@ protected: // Protected to allow access for unit testing
     void TYA();
 
     // Convenience method for branch instructions (BCC, BCS, etc.).
-    void branch_if(bool condition);
+    void branch_if(bool condition, uint16_t address);
 
     // Convenience method for compare instructions (CPX, CPY, CMP).
-    void compare(uint8_t _register);
+    void compare(uint8_t _register, uint8_t data);
 
     // Convenience method for working with interrupts (NMI, IRQ, BRK)
     void interrupt(InterruptType type);
@@ -150,19 +211,19 @@ protected: // Protected to allow access for unit testing
     // - https://www.nesdev.org/obelisk-6502-guide/reference.html
     // - http://archive.6502.org/datasheets/rockwell_r650x_r651x.pdf
     // - https://www.masswerk.at/6502/6502_instruction_set.html
-    void implied();
-    void accumulator();
-    void immediate();
-    void zero_page();
-    void zero_page_x();
-    void zero_page_y();
-    void absolute();
-    void absolute_x();
-    void absolute_y();
-    void indirect();
-    void indirect_x();
-    void indirect_y();
-    void relative();
+    uint16_t implied();
+    uint16_t accumulator();
+    uint16_t immediate(uint16_t operand);
+    uint16_t zero_page(uint16_t operand);
+    uint16_t zero_page_x(uint16_t operand);
+    uint16_t zero_page_y(uint16_t operand);
+    uint16_t absolute(uint16_t operand);
+    uint16_t absolute_x(uint16_t operand);
+    uint16_t absolute_y(uint16_t operand);
+    uint16_t indirect(uint16_t operand);
+    uint16_t indirect_x(uint16_t operand);
+    uint16_t indirect_y(uint16_t operand);
+    uint16_t relative(uint16_t operand);
     //endregion
 };
 
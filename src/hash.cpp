@@ -0,0 +1,118 @@
+#include "hash.h"
+#include <algorithm>
+#include <bit>
+
+namespace hash {
+    // Slicing-by-8: table k gives the CRC of a byte followed by k zero
+    // bytes, so eight bytes can be folded in at a time with independent
+    // lookups. (The SSE4.2 crc32 instruction computes CRC-32C, which has a
+    // different polynomial, so it's no use for matching ROM databases.)
+    constexpr std::array<std::array<uint32_t, 256>, 8> make_crc_tables() {
+        std::array<std::array<uint32_t, 256>, 8> tables{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320 : 0);
+            }
+            tables[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int k = 1; k < 8; k++) {
+                uint32_t previous = tables[k - 1][i];
+                tables[k][i] = (previous >> 8) ^ tables[0][previous & 0xFF];
+            }
+        }
+        return tables;
+    }
+
+    constexpr auto CRC_TABLES = make_crc_tables();
+
+    static uint32_t load_le32(const uint8_t *bytes) {
+        return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+    }
+
+    uint32_t crc32(std::span<const uint8_t> data, uint32_t crc) {
+        const auto &t = CRC_TABLES;
+        const uint8_t *bytes = data.data();
+        size_t size = data.size();
+        crc = ~crc;
+        for (; size >= 8; bytes += 8, size -= 8) {
+            uint32_t low = crc ^ load_le32(bytes);
+            uint32_t high = load_le32(bytes + 4);
+            crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+                  t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        }
+        for (; size > 0; bytes++, size--) {
+            crc = t[0][(crc ^ *bytes) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    // See FIPS 180-4, section 6.1.
+    static void sha1_block(std::array<uint32_t, 5> &state, const uint8_t *block) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            w[i] = block[i * 4] << 24 | block[i * 4 + 1] << 16 | block[i * 4 + 2] << 8 | block[i * 4 + 3];
+        }
+        for (int i = 16; i < 80; i++) {
+            w[i] = std::rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        auto [a, b, c, d, e] = state;
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t temp = std::rotl(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = std::rotl(b, 30);
+            b = a;
+            a = temp;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+
+    std::array<uint8_t, 20> sha1(std::span<const uint8_t> data) {
+        std::array<uint32_t, 5> state{0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+        size_t whole = data.size() & ~size_t(63);
+        for (size_t offset = 0; offset < whole; offset += 64) {
+            sha1_block(state, &data[offset]);
+        }
+
+        // Pad the rest with a 1 bit, zeroes, and the length in bits.
+        uint8_t tail[128] = {};
+        size_t rest = data.size() - whole;
+        std::copy(data.begin() + whole, data.end(), tail);
+        tail[rest] = 0x80;
+        size_t tail_size = rest < 56 ? 64 : 128;
+        uint64_t bits = static_cast<uint64_t>(data.size()) * 8;
+        for (int i = 0; i < 8; i++) {
+            tail[tail_size - 1 - i] = bits >> (i * 8);
+        }
+        for (size_t offset = 0; offset < tail_size; offset += 64) {
+            sha1_block(state, tail + offset);
+        }
+
+        std::array<uint8_t, 20> digest{};
+        for (int i = 0; i < 20; i++) {
+            digest[i] = state[i / 4] >> (24 - (i % 4) * 8);
+        }
+        return digest;
+    }
+}
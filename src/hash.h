@@ -0,0 +1,20 @@
+#ifndef NES_HASH_H
+#define NES_HASH_H
+
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+// Checksums ROM databases identify dumps by (of PRG-ROM and CHR-ROM, without
+// the header).
+namespace hash {
+    // CRC-32 (the zlib/PNG polynomial). Pass the previous result as the
+    // initial value to continue over more data.
+    uint32_t crc32(std::span<const uint8_t> data, uint32_t crc = 0);
+
+    std::array<uint8_t, 20> sha1(std::span<const uint8_t> data);
+}
+
+
+#endif //NES_HASH_H
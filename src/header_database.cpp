@@ -0,0 +1,55 @@
+#include "header_database.h"
+#include <fstream>
+#include <sstream>
+#include "log.h"
+
+bool HeaderDatabase::load(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        LOG_ERROR("Could not open header database at path " << path)
+        return false;
+    }
+
+    std::string line;
+    for (int number = 1; std::getline(file, line); number++) {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        uint32_t crc;
+        unsigned mapper;
+        char mirroring;
+        uint32_t prg_ram_kb;
+        if (!(fields >> std::hex >> crc)) {
+            continue; // blank or comment
+        }
+        if (!(fields >> std::dec >> mapper >> mirroring >> prg_ram_kb) ||
+            (mirroring != 'H' && mirroring != 'V' && mirroring != '4')) {
+            LOG_ERROR("Invalid header database entry at " << path << ":" << number)
+            return false;
+        }
+        Mapper::Mirror mirror = mirroring == 'H' ? Mapper::Horizontal :
+                                mirroring == 'V' ? Mapper::Vertical : Mapper::FourScreen;
+        add(crc, {static_cast<uint16_t>(mapper), mirror, prg_ram_kb * 1024});
+    }
+    return true;
+}
+
+void HeaderDatabase::add(uint32_t crc, const Correction &correction) {
+    corrections[crc] = correction;
+}
+
+const HeaderDatabase::Correction *HeaderDatabase::find(uint32_t crc) const {
+    auto it = corrections.find(crc);
+    return it == corrections.end() ? nullptr : &it->second;
+}
+
+bool HeaderDatabase::correct(uint32_t crc, RomInfo &info) const {
+    const Correction *correction = find(crc);
+    if (!correction) {
+        return false;
+    }
+    bool changed = info.mapper != correction->mapper || info.mirror != correction->mirror ||
+                   info.prg_ram_size != correction->prg_ram_size;
+    info.mapper = correction->mapper;
+    info.mirror = correction->mirror;
+    info.prg_ram_size = correction->prg_ram_size;
+    return changed;
+}
@@ -0,0 +1,41 @@
+#ifndef NES_HEADER_DATABASE_H
+#define NES_HEADER_DATABASE_H
+
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "rom_info.h"
+
+// Known-good header fields for dumps that are commonly found with bad iNES
+// headers, looked up by the CRC-32 of their PRG-ROM and CHR-ROM.
+//
+// The database is a text file with one dump per line:
+//
+//     # crc32   mapper  mirroring  prg-ram (KB)
+//     1a2b3c4d  4       V          8
+//
+// where mirroring is H (horizontal), V (vertical) or 4 (four-screen).
+class HeaderDatabase {
+public:
+    struct Correction {
+        uint16_t mapper;
+        Mapper::Mirror mirror;
+        uint32_t prg_ram_size; // in bytes
+    };
+
+    // Add the corrections in the file. Returns false if it can't be read or
+    // has a line that can't be parsed.
+    bool load(const std::string &path);
+    void add(uint32_t crc, const Correction &correction);
+    [[nodiscard]] const Correction *find(uint32_t crc) const;
+    // Apply the correction for the dump with the CRC (if there is one) to
+    // its info. Returns whether anything was changed.
+    bool correct(uint32_t crc, RomInfo &info) const;
+    [[nodiscard]] size_t size() const { return corrections.size(); }
+private:
+    std::unordered_map<uint32_t, Correction> corrections;
+};
+
+
+#endif //NES_HEADER_DATABASE_H
@@ -3,8 +3,13 @@
 
 #include <string>
 #include <iostream>
+#include <iomanip>
 
+// Trace logging can be turned off at build time (-DLOG_TRACE_ENABLED=0),
+// which is needed for any kind of performance measurement.
+#ifndef LOG_TRACE_ENABLED
 #define LOG_TRACE_ENABLED 1
+#endif
 
 // TODO Add more robust logging
 #define LOG_WITH_LEVEL(ostream, level, s) ostream << "[" << std::setfill(' ') << std::setw(13)  << __FILE_NAME__ << ":" << std::setfill('0') << std::setw(3) << __LINE__ << "][" << level << "] " << s << std::dec << std::endl;
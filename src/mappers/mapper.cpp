@@ -1,7 +1,44 @@
 #include "mapper.h"
+#include <algorithm>
+
+Mapper::Mapper(uint32_t prg_size, uint32_t chr_size) : prg_size(prg_size), chr_size(chr_size) {
+}
+
+Mapper::~Mapper() = default;
+
+bool Mapper::write(uint16_t /*address*/, uint8_t /*data*/) {
+    // Boards without any registers ignore writes to ROM.
+    return false;
+}
+
+void Mapper::clock_scanline() {
+}
+
+unsigned Mapper::scanlines_until_irq() const {
+    return 0;
+}
 
 Mapper::Type Mapper::get_type() {
     return type;
 }
 
-Mapper::~Mapper() = default;
+// Offset of a bank of the given size, wrapping around the size of memory.
+// Memory smaller than the bank is mirrored to fill it.
+static uint32_t bank_offset(int bank, uint32_t bank_size, uint32_t memory_size) {
+    int banks = std::max(1, static_cast<int>(memory_size / bank_size));
+    return ((bank % banks + banks) % banks) * bank_size;
+}
+
+void Mapper::map_prg(uint8_t first_window, uint8_t windows, int bank) {
+    uint32_t offset = bank_offset(bank, windows * PRG_BANK_SIZE, prg_size);
+    for (uint8_t i = 0; i < windows; i++) {
+        prg_banks[first_window + i] = (offset + i * PRG_BANK_SIZE) % prg_size;
+    }
+}
+
+void Mapper::map_chr(uint8_t first_window, uint8_t windows, int bank) {
+    uint32_t offset = bank_offset(bank, windows * CHR_BANK_SIZE, chr_size);
+    for (uint8_t i = 0; i < windows; i++) {
+        chr_banks[first_window + i] = (offset + i * CHR_BANK_SIZE) % chr_size;
+    }
+}
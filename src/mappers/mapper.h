@@ -2,21 +2,80 @@
 #define NES_MAPPER_H
 
 
+#include <array>
 #include <cstdint>
 
+// Maps the cartridge's PRG and CHR memory into the CPU and PPU address
+// spaces. Rather than translating every access, a mapper publishes which
+// bank is in each window of the address space, and only changes those
+// tables when one of its registers is written. Reads are then just an index
+// into the table plus a load.
+//
+// PRG is mapped in 8KB windows at $8000-$FFFF and CHR in 1KB windows at
+// $0000-$1FFF, the smallest banks any of the supported mappers switch.
 class Mapper {
 public:
     enum Type {
         NROM = 0,
         MMC1 = 1,
+        UxROM = 2,
         CNROM = 3,
+        MMC3 = 4,
     };
+
+    // Nametable mirroring, i.e. how the PPU's four logical nametables map
+    // onto its 2KB of VRAM (and any extra VRAM on the cartridge).
+    enum Mirror {
+        Horizontal,
+        Vertical,
+        FourScreen,
+        SingleScreenLower,
+        SingleScreenUpper,
+    };
+
+    static constexpr uint32_t PRG_BANK_SIZE = 0x2000;
+    static constexpr uint32_t CHR_BANK_SIZE = 0x0400;
+
+    // The sizes are of the cartridge's PRG and CHR memory in bytes.
+    Mapper(uint32_t prg_size, uint32_t chr_size);
     virtual ~Mapper();
-    virtual uint16_t map_address_prg(uint16_t address) = 0;
-    virtual uint16_t map_address_chr(uint16_t address) = 0;
+
+    // Handle a CPU write to $8000-$FFFF. Returns whether it changed the
+    // banks or the mirroring, in which case they have to be mapped again.
+    virtual bool write(uint16_t address, uint8_t data);
+
+    // Mappers that count scanlines (MMC3) see one rising edge of PPU A12
+    // per rendered line, which the PPU reports here.
+    virtual void clock_scanline();
+    // How many more scanlines until the mapper raises an IRQ, or 0 if it
+    // won't. The bus uses this to schedule the IRQ instead of polling.
+    [[nodiscard]] virtual unsigned scanlines_until_irq() const;
+    // Whether the mapper is holding the CPU's IRQ line low.
+    [[nodiscard]] bool is_irq_pending() const { return irq; }
+
+    // Offset into PRG memory of the bank in each window ($8000, $A000,
+    // $C000 and $E000).
+    [[nodiscard]] const std::array<uint32_t, 4> &get_prg_banks() const { return prg_banks; }
+    // Offset into CHR memory of the bank in each 1KB window.
+    [[nodiscard]] const std::array<uint32_t, 8> &get_chr_banks() const { return chr_banks; }
+    [[nodiscard]] Mirror get_mirror() const { return mirror; }
+    void set_mirror(Mirror mirror) { this->mirror = mirror; }
     Type get_type();
 protected:
     Type type;
+    uint32_t prg_size;
+    uint32_t chr_size;
+    std::array<uint32_t, 4> prg_banks{};
+    std::array<uint32_t, 8> chr_banks{};
+    Mirror mirror = Horizontal;
+    bool irq = false;
+
+    // Map the given bank into a range of consecutive windows, where banks
+    // are the size of the whole range. Negative banks count back from the
+    // end of memory (-1 is the last bank), and banks past the end wrap
+    // around, the way the unconnected high bank lines do on a real board.
+    void map_prg(uint8_t first_window, uint8_t windows, int bank);
+    void map_chr(uint8_t first_window, uint8_t windows, int bank);
 };
 
 
@@ -0,0 +1,14 @@
+#include "mapper_cnrom.h"
+
+MapperCNROM::MapperCNROM(uint32_t prg_size, uint32_t chr_size) : Mapper(prg_size, chr_size) {
+    type = CNROM;
+    map_prg(0, 4, 0);
+    map_chr(0, 8, 0);
+}
+
+MapperCNROM::~MapperCNROM() = default;
+
+bool MapperCNROM::write(uint16_t /*address*/, uint8_t data) {
+    map_chr(0, 8, data);
+    return true;
+}
@@ -0,0 +1,17 @@
+#ifndef NES_MAPPER_CNROM_H
+#define NES_MAPPER_CNROM_H
+
+
+#include "mapper.h"
+
+// CNROM switches the whole 8KB of CHR-ROM. PRG is fixed like NROM.
+// See https://www.nesdev.org/wiki/CNROM
+class MapperCNROM : public Mapper {
+public:
+    MapperCNROM(uint32_t prg_size, uint32_t chr_size);
+    ~MapperCNROM() override;
+    bool write(uint16_t address, uint8_t data) override;
+};
+
+
+#endif //NES_MAPPER_CNROM_H
@@ -0,0 +1,63 @@
+#include "mapper_mmc1.h"
+
+MapperMMC1::MapperMMC1(uint32_t prg_size, uint32_t chr_size) : Mapper(prg_size, chr_size) {
+    type = MMC1;
+    map_banks();
+}
+
+MapperMMC1::~MapperMMC1() = default;
+
+bool MapperMMC1::write(uint16_t address, uint8_t data) {
+    // Writing a byte with bit 7 set resets the shift register, and locks
+    // the last PRG bank at $C000.
+    if (data & 0x80) {
+        shift = 0x10;
+        control |= 0x0C;
+        map_banks();
+        return true;
+    }
+
+    bool full = shift & 0x01;
+    shift = (shift >> 1) | ((data & 0x01) << 4);
+    if (!full) {
+        return false;
+    }
+    switch ((address >> 13) & 0x03) {
+        case 0: control = shift; break;
+        case 1: chr_bank_0 = shift; break;
+        case 2: chr_bank_1 = shift; break;
+        default: prg_bank = shift; break;
+    }
+    shift = 0x10;
+    map_banks();
+    return true;
+}
+
+void MapperMMC1::map_banks() {
+    static const Mirror mirrors[] = {SingleScreenLower, SingleScreenUpper, Vertical, Horizontal};
+    mirror = mirrors[control & 0x03];
+
+    switch ((control >> 2) & 0x03) {
+        case 0:
+        case 1:
+            // 32KB at a time, ignoring the low bit of the bank.
+            map_prg(0, 4, (prg_bank & 0x0F) >> 1);
+            break;
+        case 2:
+            map_prg(0, 2, 0);
+            map_prg(2, 2, prg_bank & 0x0F);
+            break;
+        default:
+            map_prg(0, 2, prg_bank & 0x0F);
+            map_prg(2, 2, -1);
+            break;
+    }
+
+    if (control & 0x10) {
+        // Two separate 4KB banks.
+        map_chr(0, 4, chr_bank_0);
+        map_chr(4, 4, chr_bank_1);
+    } else {
+        map_chr(0, 8, chr_bank_0 >> 1);
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef NES_MAPPER_MMC1_H
+#define NES_MAPPER_MMC1_H
+
+
+#include "mapper.h"
+
+// MMC1 (SxROM) takes its registers a bit at a time through a serial shift
+// register. Five writes fill it, and the address of the last one picks the
+// register it's copied to.
+// See https://www.nesdev.org/wiki/MMC1
+class MapperMMC1 : public Mapper {
+public:
+    MapperMMC1(uint32_t prg_size, uint32_t chr_size);
+    ~MapperMMC1() override;
+    bool write(uint16_t address, uint8_t data) override;
+private:
+    uint8_t shift = 0x10; // the 1 reaches bit 0 once four bits have been shifted in
+    uint8_t control = 0x0C;
+    uint8_t chr_bank_0 = 0;
+    uint8_t chr_bank_1 = 0;
+    uint8_t prg_bank = 0;
+
+    void map_banks();
+};
+
+
+#endif //NES_MAPPER_MMC1_H
@@ -0,0 +1,87 @@
+#include "mapper_mmc3.h"
+
+MapperMMC3::MapperMMC3(uint32_t prg_size, uint32_t chr_size) : Mapper(prg_size, chr_size) {
+    type = MMC3;
+    map_banks();
+}
+
+MapperMMC3::~MapperMMC3() = default;
+
+bool MapperMMC3::write(uint16_t address, uint8_t data) {
+    // Each 8KB range has a pair of registers, picked by bit 0.
+    switch (address & 0xE001) {
+        case 0x8000:
+            bank_select = data;
+            break;
+        case 0x8001:
+            banks[bank_select & 0x07] = data;
+            break;
+        case 0xA000:
+            if (mirror == FourScreen) {
+                return false;
+            }
+            mirror = (data & 0x01) ? Horizontal : Vertical;
+            break;
+        case 0xA001:
+            return false; // PRG-RAM protect
+        case 0xC000:
+            irq_latch = data;
+            return false;
+        case 0xC001:
+            irq_counter = 0;
+            irq_reload = true;
+            return false;
+        case 0xE000:
+            // Disabling IRQs also acknowledges one that's pending.
+            irq_enabled = false;
+            irq = false;
+            return false;
+        default:
+            irq_enabled = true;
+            return false;
+    }
+    map_banks();
+    return true;
+}
+
+void MapperMMC3::clock_scanline() {
+    if (irq_counter == 0 || irq_reload) {
+        irq_counter = irq_latch;
+        irq_reload = false;
+    } else {
+        irq_counter--;
+    }
+    if (irq_counter == 0 && irq_enabled) {
+        irq = true;
+    }
+}
+
+unsigned MapperMMC3::scanlines_until_irq() const {
+    if (!irq_enabled) {
+        return 0;
+    }
+    // The next clock reloads the counter, and it then counts down to 0.
+    if (irq_counter == 0 || irq_reload) {
+        return irq_latch + 1u;
+    }
+    return irq_counter;
+}
+
+void MapperMMC3::map_banks() {
+    // PRG mode 0 switches $8000 and fixes the second to last bank at
+    // $C000, mode 1 swaps the two.
+    bool prg_swapped = bank_select & 0x40;
+    map_prg(prg_swapped ? 2 : 0, 1, banks[6]);
+    map_prg(1, 1, banks[7]);
+    map_prg(prg_swapped ? 0 : 2, 1, -2);
+    map_prg(3, 1, -1);
+
+    // R0 and R1 are 2KB banks (in 1KB units, ignoring the low bit), and
+    // R2-R5 are 1KB banks. CHR inversion swaps which half each goes in.
+    uint8_t inverted = (bank_select & 0x80) ? 4 : 0;
+    map_chr(inverted + 0, 2, banks[0] >> 1);
+    map_chr(inverted + 2, 2, banks[1] >> 1);
+    for (uint8_t i = 0; i < 4; i++) {
+        map_chr((inverted ^ 4) + i, 1, banks[2 + i]);
+    }
+}
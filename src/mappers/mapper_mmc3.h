@@ -0,0 +1,32 @@
+#ifndef NES_MAPPER_MMC3_H
+#define NES_MAPPER_MMC3_H
+
+
+#include <array>
+#include "mapper.h"
+
+// MMC3 (TxROM) switches 8KB PRG banks and 1KB/2KB CHR banks through a bank
+// select and bank data register pair, and has a scanline counter that
+// raises an IRQ when it runs out (used for status bars and split scrolling).
+// See https://www.nesdev.org/wiki/MMC3
+class MapperMMC3 : public Mapper {
+public:
+    MapperMMC3(uint32_t prg_size, uint32_t chr_size);
+    ~MapperMMC3() override;
+    bool write(uint16_t address, uint8_t data) override;
+    void clock_scanline() override;
+    [[nodiscard]] unsigned scanlines_until_irq() const override;
+private:
+    uint8_t bank_select = 0;
+    std::array<uint8_t, 8> banks{0, 2, 4, 5, 6, 7, 0, 1}; // R0-R7
+
+    uint8_t irq_latch = 0;
+    uint8_t irq_counter = 0;
+    bool irq_reload = false;
+    bool irq_enabled = false;
+
+    void map_banks();
+};
+
+
+#endif //NES_MAPPER_MMC3_H
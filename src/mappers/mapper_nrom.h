@@ -4,14 +4,12 @@
 
 #include "mapper.h"
 
+// NROM has no registers: 16KB or 32KB of PRG-ROM (16KB is mirrored into
+// both halves) and 8KB of CHR.
 class MapperNROM : public Mapper {
 public:
-    explicit MapperNROM(uint8_t prg_rom_size);
+    MapperNROM(uint32_t prg_size, uint32_t chr_size);
     ~MapperNROM() override;
-    uint16_t map_address_prg(uint16_t address) override;
-    uint16_t map_address_chr(uint16_t address) override;
-private:
-    uint8_t prg_rom_size;
 };
 
 
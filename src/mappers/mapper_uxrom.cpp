@@ -0,0 +1,16 @@
+#include "mapper_uxrom.h"
+
+MapperUxROM::MapperUxROM(uint32_t prg_size, uint32_t chr_size) : Mapper(prg_size, chr_size) {
+    type = UxROM;
+    map_prg(0, 2, 0);
+    map_prg(2, 2, -1);
+    map_chr(0, 8, 0);
+}
+
+MapperUxROM::~MapperUxROM() = default;
+
+bool MapperUxROM::write(uint16_t /*address*/, uint8_t data) {
+    // Any write to ROM selects the bank.
+    map_prg(0, 2, data);
+    return true;
+}
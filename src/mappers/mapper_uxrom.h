@@ -0,0 +1,18 @@
+#ifndef NES_MAPPER_UXROM_H
+#define NES_MAPPER_UXROM_H
+
+
+#include "mapper.h"
+
+// UxROM switches a 16KB PRG bank at $8000, with the last bank fixed at
+// $C000. CHR is 8KB, usually RAM.
+// See https://www.nesdev.org/wiki/UxROM
+class MapperUxROM : public Mapper {
+public:
+    MapperUxROM(uint32_t prg_size, uint32_t chr_size);
+    ~MapperUxROM() override;
+    bool write(uint16_t address, uint8_t data) override;
+};
+
+
+#endif //NES_MAPPER_UXROM_H
@@ -0,0 +1,137 @@
+#include "palette.h"
+
+// See https://www.nesdev.org/wiki/PPU_palettes#2C02
+static const std::array<Palette::Color, 64> NTSC_COLORS = {{
+    {84, 84, 84},
+    {0, 30, 116},
+    {8, 16, 144},
+    {48, 0, 136},
+    {68, 0, 100},
+    {92, 0, 48},
+    {84, 4, 0},
+    {60, 24, 0},
+    {32, 42, 0},
+    {8, 58, 0},
+    {0, 64, 0},
+    {0, 60, 0},
+    {0, 50, 60},
+    {0, 0, 0},
+    {0, 0, 0},
+    {0, 0, 0},
+    {152, 150, 152},
+    {8, 76, 196},
+    {48, 50, 236},
+    {92, 30, 228},
+    {136, 20, 176},
+    {160, 20, 100},
+    {152, 34, 32},
+    {120, 60, 0},
+    {84, 90, 0},
+    {40, 114, 0},
+    {8, 124, 0},
+    {0, 118, 40},
+    {0, 102, 120},
+    {0, 0, 0},
+    {0, 0, 0},
+    {0, 0, 0},
+    {236, 238, 236},
+    {76, 154, 236},
+    {120, 124, 236},
+    {176, 98, 236},
+    {228, 84, 236},
+    {236, 88, 180},
+    {236, 106, 100},
+    {212, 136, 32},
+    {160, 170, 0},
+    {116, 196, 0},
+    {76, 208, 32},
+    {56, 204, 108},
+    {56, 180, 204},
+    {60, 60, 60},
+    {0, 0, 0},
+    {0, 0, 0},
+    {236, 238, 236},
+    {168, 204, 236},
+    {188, 188, 236},
+    {212, 178, 236},
+    {236, 174, 236},
+    {236, 174, 212},
+    {236, 180, 176},
+    {228, 196, 144},
+    {204, 210, 120},
+    {180, 222, 120},
+    {168, 226, 144},
+    {152, 226, 180},
+    {160, 214, 228},
+    {160, 162, 160},
+    {0, 0, 0},
+    {0, 0, 0},
+}};
+
+// How much emphasizing a color dims the other two, see
+// https://www.nesdev.org/wiki/NTSC_video#Color_Tint_Bits
+const double EMPHASIS_ATTENUATION = 0.816328;
+
+Palette::Palette() {
+    for (uint16_t pixel = 0; pixel < SIZE; pixel++) {
+        Color color = NTSC_COLORS[pixel & ColorIndex];
+        if (pixel & (EmphasizeRed | EmphasizeGreen | EmphasizeBlue)) {
+            double r = color.r, g = color.g, b = color.b;
+            if (pixel & EmphasizeRed) {
+                g *= EMPHASIS_ATTENUATION;
+                b *= EMPHASIS_ATTENUATION;
+            }
+            if (pixel & EmphasizeGreen) {
+                r *= EMPHASIS_ATTENUATION;
+                b *= EMPHASIS_ATTENUATION;
+            }
+            if (pixel & EmphasizeBlue) {
+                r *= EMPHASIS_ATTENUATION;
+                g *= EMPHASIS_ATTENUATION;
+            }
+            color = {(uint8_t) r, (uint8_t) g, (uint8_t) b};
+        }
+
+        colors[pixel] = color;
+        rgba32[pixel] = color.r | (color.g << 8) | (color.b << 16) | (0xFFu << 24);
+        rgb565[pixel] = ((color.r >> 3) << 11) | ((color.g >> 2) << 5) | (color.b >> 3);
+        grayscale[pixel] = (color.r * 299 + color.g * 587 + color.b * 114) / 1000;
+    }
+}
+
+Palette::Color Palette::color(uint16_t pixel) const {
+    return colors[pixel & (SIZE - 1)];
+}
+
+// The conversions are unrolled by hand so the loads, lookups and stores of
+// several pixels can be in flight at once. Masking the pixel keeps a stray
+// value from reading outside the table, and costs nothing next to the load.
+template<typename T>
+static void convert(const uint16_t *pixels, T *out, size_t count, const std::array<T, Palette::SIZE> &table) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        T a = table[pixels[i] & (Palette::SIZE - 1)];
+        T b = table[pixels[i + 1] & (Palette::SIZE - 1)];
+        T c = table[pixels[i + 2] & (Palette::SIZE - 1)];
+        T d = table[pixels[i + 3] & (Palette::SIZE - 1)];
+        out[i] = a;
+        out[i + 1] = b;
+        out[i + 2] = c;
+        out[i + 3] = d;
+    }
+    for (; i < count; i++) {
+        out[i] = table[pixels[i] & (Palette::SIZE - 1)];
+    }
+}
+
+void Palette::to_rgba32(const uint16_t *pixels, uint32_t *out, size_t count) const {
+    convert(pixels, out, count, rgba32);
+}
+
+void Palette::to_rgb565(const uint16_t *pixels, uint16_t *out, size_t count) const {
+    convert(pixels, out, count, rgb565);
+}
+
+void Palette::to_grayscale(const uint16_t *pixels, uint8_t *out, size_t count) const {
+    convert(pixels, out, count, grayscale);
+}
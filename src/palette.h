@@ -0,0 +1,49 @@
+#ifndef NES_PALETTE_H
+#define NES_PALETTE_H
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Converts the PPU's framebuffer into pixels that can be displayed.
+//
+// The PPU only writes a 9-bit value for each pixel: the 6-bit color index
+// from palette RAM (with PPUMASK's grayscale already applied) and the three
+// PPUMASK emphasis bits above it. Every one of the 512 possible values is
+// converted ahead of time into each output format, so converting a frame
+// is one table lookup per pixel, and consumers that are happy with color
+// indexes can skip it altogether.
+class Palette {
+public:
+    struct Color {
+        uint8_t r, g, b;
+    };
+
+    // Bits of a framebuffer pixel.
+    enum Pixel : uint16_t {
+        ColorIndex      = 0x003F,
+        EmphasizeRed    = 1 << 6,
+        EmphasizeGreen  = 1 << 7,
+        EmphasizeBlue   = 1 << 8,
+    };
+    static constexpr size_t SIZE = 512;
+
+    Palette();
+
+    [[nodiscard]] Color color(uint16_t pixel) const;
+
+    // RGBA with red in the lowest byte (R, G, B, A in memory on little
+    // endian machines).
+    void to_rgba32(const uint16_t *pixels, uint32_t *out, size_t count) const;
+    void to_rgb565(const uint16_t *pixels, uint16_t *out, size_t count) const;
+    void to_grayscale(const uint16_t *pixels, uint8_t *out, size_t count) const;
+private:
+    std::array<Color, SIZE> colors;
+    std::array<uint32_t, SIZE> rgba32;
+    std::array<uint16_t, SIZE> rgb565;
+    std::array<uint8_t, SIZE> grayscale;
+};
+
+
+#endif //NES_PALETTE_H
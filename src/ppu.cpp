@@ -1,81 +1,19 @@
 #include "ppu.h"
+#include <algorithm>
+#include <bit>
 #include <cstdlib>
+#include "cartridge.h"
+#include "compositor.h"
 
-size_t SCREEN_WIDTH = 256;
-size_t SCREEN_HEIGHT = 240;
-size_t HBLANK_PIXELS = 85;
-size_t VBLANK_SCANLINES = 22;
-size_t SCANLINE_CYCLES = SCREEN_WIDTH + HBLANK_PIXELS;
-size_t SCREEN_CYCLES = SCANLINE_CYCLES * (SCREEN_HEIGHT + VBLANK_SCANLINES);
+// Scanline timing, see https://www.nesdev.org/wiki/PPU_rendering (the
+// number of lines and where vblank starts depend on the region).
+const uint16_t DOTS_PER_SCANLINE = 341;
+const uint16_t INCREMENT_Y_DOT = 256;
+const uint16_t COPY_X_DOT = 257;
+const uint16_t COPY_Y_DOT = 280;
 
 Ppu::Ppu() {
-    // See https://www.nesdev.org/wiki/PPU_palettes#2C02
-    palette = {
-        Ppu::Color(84, 84, 84),
-        Ppu::Color(0, 30, 116),
-        Ppu::Color(8, 16, 144),
-        Ppu::Color(48, 0, 136),
-        Ppu::Color(68, 0, 100),
-        Ppu::Color(92, 0, 48),
-        Ppu::Color(84, 4, 0),
-        Ppu::Color(60, 24, 0),
-        Ppu::Color(32, 42, 0),
-        Ppu::Color(8, 58, 0),
-        Ppu::Color(0, 64, 0),
-        Ppu::Color(0, 60, 0),
-        Ppu::Color(0, 50, 60),
-        Ppu::Color(0, 0, 0),
-        Ppu::Color(0, 0, 0),
-        Ppu::Color(0, 0, 0),
-        Ppu::Color(152, 150, 152),
-        Ppu::Color(8, 76, 196),
-        Ppu::Color(48, 50, 236),
-        Ppu::Color(92, 30, 228),
-        Ppu::Color(136, 20, 176),
-        Ppu::Color(160, 20, 100),
-        Ppu::Color(152, 34, 32),
-        Ppu::Color(120, 60, 0),
-        Ppu::Color(84, 90, 0),
-        Ppu::Color(40, 114, 0),
-        Ppu::Color(8, 124, 0),
-        Ppu::Color(0, 118, 40),
-        Ppu::Color(0, 102, 120),
-        Ppu::Color(0, 0, 0),
-        Ppu::Color(0, 0, 0),
-        Ppu::Color(0, 0, 0),
-        Ppu::Color(236, 238, 236),
-        Ppu::Color(76, 154, 236),
-        Ppu::Color(120, 124, 236),
-        Ppu::Color(176, 98, 236),
-        Ppu::Color(228, 84, 236),
-        Ppu::Color(236, 88, 180),
-        Ppu::Color(236, 106, 100),
-        Ppu::Color(212, 136, 32),
-        Ppu::Color(160, 170, 0),
-        Ppu::Color(116, 196, 0),
-        Ppu::Color(76, 208, 32),
-        Ppu::Color(56, 204, 108),
-        Ppu::Color(56, 180, 204),
-        Ppu::Color(60, 60, 60),
-        Ppu::Color(0, 0, 0),
-        Ppu::Color(0, 0, 0),
-        Ppu::Color(236, 238, 236),
-        Ppu::Color(168, 204, 236),
-        Ppu::Color(188, 188, 236),
-        Ppu::Color(212, 178, 236),
-        Ppu::Color(236, 174, 236),
-        Ppu::Color(236, 174, 212),
-        Ppu::Color(236, 180, 176),
-        Ppu::Color(228, 196, 144),
-        Ppu::Color(204, 210, 120),
-        Ppu::Color(180, 222, 120),
-        Ppu::Color(168, 226, 144),
-        Ppu::Color(152, 226, 180),
-        Ppu::Color(160, 214, 228),
-        Ppu::Color(160, 162, 160),
-        Ppu::Color(0, 0, 0),
-        Ppu::Color(0, 0, 0),
-    };
+    set_region(Region::NTSC);
 }
 
 uint8_t Ppu::cpu_read(uint16_t address) {
@@ -87,8 +25,11 @@ uint8_t Ppu::cpu_read(uint16_t address) {
             return data;
         }
         case OAMDATA:
-            return 0x0; // TODO: Handle Object Attribute Memory
+            return oam_read(oam_address);
         case PPUDATA: {
+            if (scanline < SCREEN_HEIGHT) {
+                change_picture(); // moves the VRAM address
+            }
             uint8_t data = ppu_data_buffer;
             ppu_data_buffer = ppu_read(vram_address.get_value());
             if (vram_address >= 0x3F00) {
@@ -104,15 +45,42 @@ uint8_t Ppu::cpu_read(uint16_t address) {
 }
 
 void Ppu::cpu_write(uint16_t address, uint8_t data) {
+    // Writes part way through a visible scanline take effect from the dot
+    // the PPU is on, so the rest of the line has to be redrawn afterwards.
+    bool mid_line = scanline < SCREEN_HEIGHT && dot >= 1 && dot <= SCREEN_WIDTH;
+    if (scanline < SCREEN_HEIGHT && address != OAMADDR && address != OAMDATA) {
+        change_picture();
+    }
+
     switch (address) {
-        case PPUCTRL:
+        case PPUCTRL: {
+            // Turning NMIs on during vblank raises one straight away.
+            bool nmi_enabled = control.is_set(PpuCtrl::NmiEnable);
+            uint8_t height = sprite_height();
+            bool background_tile = control.is_set(PpuCtrl::BackgroundTile);
             control.set_value(data);
+            if (sprite_height() != height) {
+                sprite_lists_dirty = true;
+            }
+            if (control.is_set(PpuCtrl::BackgroundTile) != background_tile) {
+                dirty_tiles.set();
+            }
+            if (!nmi_enabled && control.is_set(PpuCtrl::NmiEnable) && status.is_set(PpuStatus::VerticalBlank)) {
+                nmi = true;
+            }
             vram_address_temp.set(LoopyRegister::NametableX, control.get(PpuCtrl::NametableX));
             vram_address_temp.set(LoopyRegister::NametableY, control.get(PpuCtrl::NametableY));
             break;
+        }
         case PPUMASK:
             mask.set_value(data);
             break;
+        case OAMADDR:
+            oam_address = data;
+            break;
+        case OAMDATA:
+            oam_write(oam_address++, data);
+            break;
         case PPUSCROLL:
             if (!write_toggle) {
                 fine_x = data & 0x07;
@@ -122,35 +90,768 @@ void Ppu::cpu_write(uint16_t address, uint8_t data) {
                 vram_address_temp.set(LoopyRegister::CoarseY, data >> 3);
             }
             write_toggle = !write_toggle;
+            break;
         case PPUADDR:
             if (!write_toggle) {
                 vram_address_temp.set_value(((uint16_t)(data & 0x3F) << 8) | (vram_address_temp.get_value() & 0x00FF));
             } else {
                 vram_address_temp.set_value((vram_address_temp.get_value() & 0xFF00) | data);
+                vram_address = vram_address_temp;
+                if (mid_line) {
+                    line_address = vram_address;
+                    line_start_x = dot - 1;
+                }
             }
             write_toggle = !write_toggle;
+            break;
         case PPUDATA:
             ppu_write(vram_address.get_value(), data);
             vram_address += control.get_increment();
+            break;
         default:
             break;
     }
+
+    if (mid_line && timing_only) {
+        // A hit later in the line only needs checking if it can't happen now.
+        if (sprite_zero_hit_dot >= dot && !(mask.is_set(PpuMask::ShowBackground) && mask.is_set(PpuMask::ShowSprites))) {
+            sprite_zero_hit_dot = 0;
+        }
+    } else if (mid_line && !repeat_frame) {
+        render_from(dot - 1);
+    }
+}
+
+void Ppu::connect_cartridge(Cartridge *cartridge) {
+    this->cartridge = cartridge;
+    map_cartridge();
+}
+
+void Ppu::set_region(Region region) {
+    timing = region_timing(region);
+    switch (region) {
+        case Region::PAL:   run_lines = &Ppu::run_lines_for<PAL_TIMING>; break;
+        case Region::Dendy: run_lines = &Ppu::run_lines_for<DENDY_TIMING>; break;
+        default:            run_lines = &Ppu::run_lines_for<NTSC_TIMING>; break;
+    }
+}
+
+void Ppu::map_cartridge() {
+    for (uint8_t table = 0; table < 4; table++) {
+        uint8_t *page = cartridge->nametable_page(table, ciram.data());
+        if (page != nametables[table]) {
+            change_picture();
+            nametables[table] = page;
+            dirty_tiles.set();
+        }
+    }
+    const std::array<uint32_t, 8> &banks = cartridge->get_chr_banks();
+    if (banks == chr_banks) {
+        return;
+    }
+    change_picture();
+
+    // Only the background's half of the pattern tables is drawn into the
+    // plane, and of that only tiles whose pattern is in a switched 1KB bank
+    // (64 patterns each) have to be drawn again.
+    uint8_t first_bank = control.is_set(PpuCtrl::BackgroundTile) ? 4 : 0;
+    uint8_t switched = 0;
+    for (uint8_t bank = 0; bank < 4; bank++) {
+        if (banks[first_bank + bank] != chr_banks[first_bank + bank]) {
+            switched |= 1 << bank;
+        }
+    }
+    chr_banks = banks;
+    if (!switched) {
+        return;
+    }
+    for (uint16_t tile = 0; tile < dirty_tiles.size(); tile++) {
+        uint16_t table = tile / PLANE_TILES_PER_TABLE;
+        if (switched & (1 << (nametables[table][tile % PLANE_TILES_PER_TABLE] >> 6))) {
+            dirty_tiles.set(tile);
+        }
+    }
 }
 
 uint8_t Ppu::ppu_read(uint16_t address) {
-    // TODO: Implement
-    return 0;
+    address &= 0x3FFF;
+    if (address < 0x2000) {
+        return cartridge ? cartridge->chr_read(address) : 0;
+    }
+    if (address < 0x3F00) {
+        return nametables[(address >> 10) & 0x03][address & 0x03FF];
+    }
+    return palette_ram[palette_index(address)];
 }
 
 void Ppu::ppu_write(uint16_t address, uint8_t data) {
-    // TODO: Implement
+    address &= 0x3FFF;
+    if (address >= 0x3F00) {
+        data &= 0x3F;
+    }
+    // Writes to CHR-ROM are dropped, so they don't change the picture.
+    if (address < 0x2000 && (!cartridge || !cartridge->is_chr_writable())) {
+        return;
+    }
+    if (ppu_read(address) == data) {
+        return;
+    }
+    change_picture();
+
+    if (address < 0x2000) {
+        cartridge->chr_write(address, data);
+        dirty_patterns.set(address >> 4);
+    } else if (address < 0x3F00) {
+        nametables[(address >> 10) & 0x03][address & 0x03FF] = data;
+        mark_background_dirty(address);
+    } else {
+        palette_ram[palette_index(address)] = data;
+    }
+}
+
+void Ppu::mark_background_dirty(uint16_t address) {
+    // The byte shows up in every nametable that's mapped to the same memory.
+    const uint8_t *page = nametables[(address >> 10) & 0x03];
+    uint16_t offset = address & 0x03FF;
+    for (uint16_t table = 0; table < 4; table++) {
+        if (nametables[table] != page) {
+            continue;
+        }
+        uint16_t first_tile = table * PLANE_TILES_PER_TABLE;
+        if (offset < PLANE_TILES_PER_TABLE) {
+            dirty_tiles.set(first_tile + offset);
+            continue;
+        }
+        // Each attribute byte colors a 4x4 block of tiles.
+        uint16_t block = offset - PLANE_TILES_PER_TABLE;
+        for (uint16_t row = (block / 8) * 4; row < (block / 8) * 4 + 4 && row < 30; row++) {
+            for (uint16_t column = (block % 8) * 4; column < (block % 8) * 4 + 4; column++) {
+                dirty_tiles.set(first_tile + row * 32 + column);
+            }
+        }
+    }
+}
+
+void Ppu::update_background_plane() {
+    // A changed pattern dirties every tile drawn with it.
+    if (dirty_patterns.any()) {
+        uint16_t pattern_table = control.is_set(PpuCtrl::BackgroundTile) ? 0x100 : 0;
+        for (uint16_t tile = 0; tile < dirty_tiles.size(); tile++) {
+            uint16_t table = tile / PLANE_TILES_PER_TABLE;
+            if (dirty_patterns[pattern_table + nametables[table][tile % PLANE_TILES_PER_TABLE]]) {
+                dirty_tiles.set(tile);
+            }
+        }
+        dirty_patterns.reset();
+    }
+    if (dirty_tiles.none()) {
+        return;
+    }
+
+    uint8_t pixels[8];
+    for (uint16_t tile = 0; tile < dirty_tiles.size(); tile++) {
+        if (!dirty_tiles[tile]) {
+            continue;
+        }
+        uint16_t table = tile / PLANE_TILES_PER_TABLE;
+        uint16_t row = (tile % PLANE_TILES_PER_TABLE) / 32;
+        uint16_t column = tile % 32;
+        uint16_t x = (table & 0x01) * SCREEN_WIDTH + column * 8;
+        uint16_t y = (table >> 1) * SCREEN_HEIGHT + row * 8;
+        for (uint16_t fine_y = 0; fine_y < 8; fine_y++) {
+            fetch_tile((fine_y << 12) | (table << 10) | (row << 5) | column, pixels);
+            std::copy_n(pixels, 8, &background_plane[(y + fine_y) * PLANE_WIDTH + x]);
+        }
+    }
+    dirty_tiles.reset();
+}
+
+uint16_t Ppu::palette_index(uint16_t address) {
+    // $3F10, $3F14, $3F18 and $3F1C mirror the background entries below them.
+    address &= 0x1F;
+    if ((address & 0x13) == 0x10) {
+        address &= ~0x10;
+    }
+    return address;
 }
 
 void Ppu::clock() {
+    run_until(dot_count + 1);
+}
+
+template<RegionTiming T>
+void Ppu::run_lines_for(uint64_t target_dot) {
+    // Work through the dots a scanline at a time, handling the events on
+    // each line as we pass them.
+    while (dot_count < target_dot) {
+        uint16_t length = scanline_length(T, scanline);
+        uint16_t end = std::min<uint64_t>(length, dot + (target_dot - dot_count));
+
+        auto passes = [this, end](uint16_t line_dot) {
+            return dot <= line_dot && line_dot < end;
+        };
+
+        bool visible = scanline < SCREEN_HEIGHT;
+        if (visible && passes(0)) {
+            if (scanline == 0) {
+                start_frame();
+            }
+            render_scanline();
+        }
+        if (visible && sprite_zero_hit_dot && passes(sprite_zero_hit_dot)) {
+            status.set(PpuStatus::SpriteZeroHit);
+            frame_hit_line = scanline;
+            frame_hit_dot = sprite_zero_hit_dot;
+        }
+        if (scanline == T.vblank_scanline && passes(1)) {
+            start_vblank();
+        } else if (scanline == T.pre_render_scanline() && passes(1)) {
+            end_vblank();
+        }
+
+        if (rendering_enabled() && (visible || scanline == T.pre_render_scanline())) {
+            if (passes(INCREMENT_Y_DOT)) {
+                increment_y(vram_address);
+            }
+            if (passes(COPY_X_DOT)) {
+                copy_x();
+            }
+            if (scanline == T.pre_render_scanline() && passes(COPY_Y_DOT)) {
+                copy_y();
+            }
+            uint16_t a12_dot = a12_rise_dot();
+            if (a12_dot && cartridge && passes(a12_dot)) {
+                cartridge->clock_scanline();
+            }
+        }
+
+        dot_count += end - dot;
+        dot = end;
+        if (dot == length) {
+            dot = 0;
+            if (++scanline == T.scanlines_per_frame) {
+                scanline = 0;
+                frame++;
+            }
+        }
+    }
+}
+
+uint64_t Ppu::next_event() {
+    // Both flags change while dot 1 of their scanline is drawn.
+    uint64_t dots = std::min(dots_until(timing.vblank_scanline, 1), dots_until(timing.pre_render_scanline(), 1));
+
+    // A hit on the line being drawn is already known, later ones have to
+    // be predicted.
+    if (scanline < SCREEN_HEIGHT && sprite_zero_hit_dot >= dot && sprite_zero_hit_dot) {
+        dots = std::min<uint64_t>(dots, sprite_zero_hit_dot - dot);
+    }
+    uint16_t hit_line, hit_dot;
+    if (predict_sprite_zero_hit(hit_line, hit_dot)) {
+        dots = std::min(dots, dots_until(hit_line, hit_dot));
+    }
+
+    // Sprite overflow is set as the first line with too many sprites on it
+    // starts to be drawn.
+    if (rendering_enabled() && !status.is_set(PpuStatus::SpriteOverflow)) {
+        if (sprite_lists_dirty) {
+            build_sprite_lists();
+        }
+        uint16_t line = scanline < SCREEN_HEIGHT ? scanline + (dot > 0) : 0;
+        while (line < SCREEN_HEIGHT && !line_overflow[line]) {
+            line++;
+        }
+        if (line < SCREEN_HEIGHT) {
+            dots = std::min(dots, dots_until(line, 0));
+        }
+    }
+    return dot_count + dots + 1;
+}
+
+uint64_t Ppu::next_frame() const {
+    uint64_t dots = dots_until(0, 0);
+    if (dots == 0) {
+        // We're at the very start of a frame, so it ends a whole frame from now.
+        dots = DOTS_PER_SCANLINE * timing.scanlines_per_frame -
+               (DOTS_PER_SCANLINE - scanline_length(timing, timing.pre_render_scanline()));
+    }
+    return dot_count + dots;
+}
+
+uint64_t Ppu::next_scanline_clock(unsigned n) const {
+    uint16_t a12_dot = a12_rise_dot();
+    if (!rendering_enabled() || !a12_dot || n == 0) {
+        return UINT64_MAX;
+    }
+
+    // Walk forward a line at a time, since the clock may be more than a
+    // frame away (the counter goes up to 256 lines) and skips vblank.
+    uint64_t dots = 0; // from the start of the current line
+    uint16_t line = scanline;
+    uint64_t odd = frame & 1;
+    for (;;) {
+        bool rendered = line < SCREEN_HEIGHT || line == timing.pre_render_scanline();
+        bool passed = dots == 0 && dot > a12_dot;
+        if (rendered && !passed && --n == 0) {
+            return dot_count - dot + dots + a12_dot + 1;
+        }
+        bool short_line = timing.short_odd_frames && line == timing.pre_render_scanline() && odd;
+        dots += DOTS_PER_SCANLINE - short_line;
+        if (++line == timing.scanlines_per_frame) {
+            line = 0;
+            odd ^= 1;
+        }
+    }
+}
+
+bool Ppu::poll_nmi() {
+    bool raised = nmi;
+    nmi = false;
+    return raised;
+}
+
+uint16_t Ppu::scanline_length(const RegionTiming &region, uint16_t line) const {
+    if (region.short_odd_frames && line == region.pre_render_scanline() && (frame & 1) && rendering_enabled()) {
+        return DOTS_PER_SCANLINE - 1;
+    }
+    return DOTS_PER_SCANLINE;
+}
+
+bool Ppu::rendering_enabled() const {
+    return mask.is_set(PpuMask::ShowBackground) || mask.is_set(PpuMask::ShowSprites);
+}
+
+uint64_t Ppu::dots_until(uint16_t line, uint16_t line_dot) const {
+    uint16_t frame_lines = timing.scanlines_per_frame;
+    uint64_t lines = (line + frame_lines - scanline) % frame_lines;
+    if (lines == 0 && line_dot < dot) {
+        lines = frame_lines;
+    }
+    uint64_t dots = lines * DOTS_PER_SCANLINE + line_dot - dot;
+
+    // Account for the short pre-render line if we'll pass the end of it.
+    if (scanline + lines >= frame_lines) {
+        dots -= DOTS_PER_SCANLINE - scanline_length(timing, timing.pre_render_scanline());
+    }
+    return dots;
+}
+
+void Ppu::start_frame() {
+    // Whether NMIs are on and how PPUDATA increments don't change the picture.
+    uint8_t control_value = control.get_value() & ~(PpuCtrl::NmiEnable | PpuCtrl::IncrementMode);
+    FrameState state{vram_address.get_value(), control_value, mask.get_value(), fine_x};
+    // A frame without pixels leaves an older one in the framebuffer.
+    bool last_drawn = !timing_only;
+    timing_only = skip_pixels;
+    repeat_frame = last_drawn && !timing_only && !picture_changed && state == frame_state;
+    frame_state = state;
+    picture_changed = false;
+    if (!repeat_frame) {
+        frame_hit_line = frame_hit_dot = 0;
+    }
+}
 
+void Ppu::change_picture() {
+    picture_changed = true;
+    if (!repeat_frame) {
+        return;
+    }
+
+    // The rest of the frame has to be drawn after all, starting with the
+    // line the PPU is part way through (unless it's already been drawn).
+    repeat_frame = false;
+    if (scanline < SCREEN_HEIGHT && dot > 0 && dot <= SCREEN_WIDTH) {
+        render_scanline();
+    }
+}
+
+void Ppu::start_vblank() {
+    status.set(PpuStatus::VerticalBlank);
+    if (control.is_set(PpuCtrl::NmiEnable)) {
+        nmi = true;
+    }
+}
+
+void Ppu::end_vblank() {
+    status.clear(PpuStatus::VerticalBlank | PpuStatus::SpriteZeroHit | PpuStatus::SpriteOverflow);
 }
 
 void Ppu::reset() {
     // TODO: Implement
     write_toggle = false;
 }
+
+bool Ppu::predict_sprite_zero_hit(uint16_t &hit_line, uint16_t &hit_dot) {
+    if (!mask.is_set(PpuMask::ShowBackground) || !mask.is_set(PpuMask::ShowSprites) ||
+        status.is_set(PpuStatus::SpriteZeroHit)) {
+        return false;
+    }
+
+    // Work out the VRAM address each upcoming line will start from, the
+    // same way it changes as the lines are drawn. Outside the visible lines
+    // the next frame starts from the temporary address (unless it's already
+    // been copied on the pre-render line).
+    bool next_frame = scanline >= SCREEN_HEIGHT;
+    LoopyRegister address = vram_address;
+    if (next_frame && !(scanline == timing.pre_render_scanline() && dot > COPY_Y_DOT)) {
+        address = vram_address_temp;
+    }
+    uint16_t line = next_frame ? 0 : scanline;
+    if (!next_frame && dot > 0) {
+        if (dot <= INCREMENT_Y_DOT) {
+            increment_y(address);
+        }
+        line++;
+    }
+
+    uint16_t top = oam.y[0] + 1;
+    uint16_t bottom = std::min<uint16_t>(top + sprite_height(), SCREEN_HEIGHT);
+    for (; line < top && line < bottom; line++) {
+        increment_y(address);
+    }
+
+    uint16_t horizontal = LoopyRegister::CoarseX | LoopyRegister::NametableX;
+    for (; line < bottom; line++) {
+        // Lines after the current one get their horizontal scroll reloaded.
+        if (next_frame || line != scanline) {
+            address.set_value((address.get_value() & ~horizontal) | (vram_address_temp.get_value() & horizontal));
+        }
+        hit_dot = sprite_zero_line_hit(address, line);
+        if (hit_dot) {
+            hit_line = line;
+            return true;
+        }
+        increment_y(address);
+    }
+    return false;
+}
+
+uint16_t Ppu::sprite_zero_line_hit(const LoopyRegister &address, uint16_t line) {
+    uint16_t top = oam.y[0] + 1;
+    if (line < top || line >= top + sprite_height()) {
+        return 0;
+    }
+
+    // Pixels sprite 0 can't hit on: the hidden left column and the last one.
+    uint8_t x = oam.x[0];
+    uint8_t allowed = 0;
+    bool left_shown = mask.is_set(PpuMask::ShowLeftBackground) && mask.is_set(PpuMask::ShowLeftSprites);
+    for (int i = 0; i < 8; i++) {
+        if (x + i < 255 && (x + i >= 8 || left_shown)) {
+            allowed |= 0x80 >> i;
+        }
+    }
+
+    uint16_t pattern = sprite_pattern(0, line - top);
+    uint8_t sprite = ppu_read(pattern) | ppu_read(pattern + 8);
+    if (oam.attributes[0] & 0x40) {
+        sprite = (sprite * 0x0202020202ULL & 0x010884422010ULL) % 1023; // reverse the bits
+    }
+    uint8_t hits = sprite & background_opacity(address, x) & allowed;
+    return hits ? x + std::countl_zero(hits) + 1 : 0;
+}
+
+uint8_t Ppu::background_opacity(LoopyRegister address, uint16_t x) {
+    uint16_t position = address.get(LoopyRegister::CoarseX) * 8 + fine_x + x;
+    uint16_t pattern_table = control.is_set(PpuCtrl::BackgroundTile) ? 0x1000 : 0;
+    uint16_t fine_y = address.get(LoopyRegister::FineY);
+
+    // The 8 pixels span (at most) two tiles.
+    uint16_t opacity = 0;
+    for (uint16_t column = position / 8; column <= position / 8 + 1; column++) {
+        uint8_t tile = ppu_read(0x2000 | (tile_address(address, column) & 0x0FFF));
+        uint16_t pattern = pattern_table + tile * 16 + fine_y;
+        opacity = (opacity << 8) | ppu_read(pattern) | ppu_read(pattern + 8);
+    }
+    return (opacity << (position & 0x07)) >> 8;
+}
+
+void Ppu::render_scanline() {
+    line_address = vram_address;
+    line_start_x = 0;
+    sprite_zero_hit_dot = 0;
+
+    if (repeat_frame || timing_only) {
+        // No pixels, just the flags the CPU can see.
+        if (rendering_enabled()) {
+            if (sprite_lists_dirty) {
+                build_sprite_lists();
+            }
+            if (line_overflow[scanline]) {
+                status.set(PpuStatus::SpriteOverflow);
+            }
+        }
+        if (repeat_frame && scanline == frame_hit_line) {
+            sprite_zero_hit_dot = frame_hit_dot;
+        } else if (timing_only && mask.is_set(PpuMask::ShowBackground) && mask.is_set(PpuMask::ShowSprites) &&
+                   !status.is_set(PpuStatus::SpriteZeroHit)) {
+            sprite_zero_hit_dot = sprite_zero_line_hit(line_address, scanline);
+        }
+        return;
+    }
+
+    if (rendering_enabled() && line_address.get(LoopyRegister::CoarseY) < 30) {
+        // Copy the line out of the background plane, wrapping around from
+        // the right hand nametables to the left.
+        update_background_plane();
+        uint16_t x = line_address.get(LoopyRegister::NametableX) * SCREEN_WIDTH +
+                     line_address.get(LoopyRegister::CoarseX) * 8 + fine_x;
+        uint16_t y = line_address.get(LoopyRegister::NametableY) * SCREEN_HEIGHT +
+                     line_address.get(LoopyRegister::CoarseY) * 8 + line_address.get(LoopyRegister::FineY);
+        const uint8_t *plane_row = &background_plane[y * PLANE_WIDTH];
+        uint16_t first = std::min<uint16_t>(SCREEN_WIDTH, PLANE_WIDTH - x);
+        std::copy_n(plane_row + x, first, background_line.begin());
+        std::copy_n(plane_row, SCREEN_WIDTH - first, background_line.begin() + first);
+        evaluate_sprites();
+    } else if (rendering_enabled()) {
+        // Rows 30 and 31 aren't in the plane, since they're the attribute
+        // table. Games rarely scroll there, so decode the 33 tiles the line
+        // touches (the first and last are only partly shown, depending on
+        // fine X), then keep the 256 pixels starting at fine X.
+        std::array<uint8_t, SCREEN_WIDTH + 8> row{};
+        LoopyRegister address = line_address;
+        for (uint16_t tile = 0; tile <= SCREEN_WIDTH / 8; tile++) {
+            fetch_tile(address.get_value(), &row[tile * 8]);
+            if (address.get(LoopyRegister::CoarseX) == 31) {
+                address.set(LoopyRegister::CoarseX, 0);
+                address.set_value(address.get_value() ^ LoopyRegister::NametableX);
+            } else {
+                address += 1;
+            }
+        }
+        std::copy_n(&row[fine_x], SCREEN_WIDTH, background_line.begin());
+        evaluate_sprites();
+    }
+    compose(0);
+}
+
+void Ppu::render_from(uint16_t x) {
+    if (sprite_zero_hit_dot > x) {
+        sprite_zero_hit_dot = 0;
+    }
+
+    if (rendering_enabled()) {
+        // Work out each pixel on its own, since the scroll may no longer
+        // line up with the start of the line.
+        uint8_t pixels[8];
+        for (uint16_t pixel = x; pixel < SCREEN_WIDTH; pixel++) {
+            uint16_t position = line_address.get(LoopyRegister::CoarseX) * 8 + fine_x + (pixel - line_start_x);
+            fetch_tile(tile_address(line_address, position / 8), pixels);
+            background_line[pixel] = pixels[position & 0x07];
+        }
+        evaluate_sprites();
+    }
+    compose(x);
+}
+
+void Ppu::fetch_tile(uint16_t address, uint8_t *pixels) {
+    // See https://www.nesdev.org/wiki/PPU_scrolling#Tile_and_attribute_fetching
+    uint8_t tile = ppu_read(0x2000 | (address & 0x0FFF));
+    uint8_t attribute = ppu_read(0x23C0 | (address & 0x0C00) | ((address >> 4) & 0x38) | ((address >> 2) & 0x07));
+    uint8_t shift = ((address >> 4) & 0x04) | (address & 0x02);
+    uint8_t palette_select = ((attribute >> shift) & 0x03) << 2;
+
+    uint16_t pattern = (control.is_set(PpuCtrl::BackgroundTile) ? 0x1000 : 0) + tile * 16 + ((address >> 12) & 0x07);
+    const uint8_t *row = pattern_row(pattern);
+    for (int i = 0; i < 8; i++) {
+        pixels[i] = row[i] ? palette_select | row[i] : 0;
+    }
+}
+
+const uint8_t *Ppu::pattern_row(uint16_t address) {
+    static const uint8_t blank[8] = {};
+    return cartridge ? cartridge->chr_row(address) : blank;
+}
+
+uint8_t Ppu::oam_read(uint8_t address) const {
+    uint8_t sprite = address >> 2;
+    switch (address & 0x03) {
+        case 0: return oam.y[sprite];
+        case 1: return oam.tile[sprite];
+        case 2: return oam.attributes[sprite];
+        default: return oam.x[sprite];
+    }
+}
+
+void Ppu::oam_write(uint8_t address, uint8_t data) {
+    if ((address & 0x03) == 2) {
+        data &= 0xE3; // bits 2-4 of the attributes don't exist
+    }
+    if (oam_read(address) == data) {
+        return;
+    }
+    change_picture();
+
+    uint8_t sprite = address >> 2;
+    switch (address & 0x03) {
+        case 0: oam.y[sprite] = data; break;
+        case 1: oam.tile[sprite] = data; break;
+        case 2: oam.attributes[sprite] = data; break;
+        default: oam.x[sprite] = data; break;
+    }
+    sprite_lists_dirty = true;
+}
+
+void Ppu::write_oam(const uint8_t *data) {
+    // DMA writes through OAMDATA, so it starts at (and wraps back around to)
+    // the current OAM address.
+    std::array<uint8_t, 256> bytes;
+    std::copy_n(data, 256 - oam_address, bytes.begin() + oam_address);
+    std::copy_n(data + 256 - oam_address, oam_address, bytes.begin());
+
+    // Most games copy their sprites every frame whether they moved or not.
+    Oam copied;
+    for (uint8_t sprite = 0; sprite < 64; sprite++) {
+        copied.y[sprite] = bytes[sprite * 4];
+        copied.tile[sprite] = bytes[sprite * 4 + 1];
+        copied.attributes[sprite] = bytes[sprite * 4 + 2] & 0xE3;
+        copied.x[sprite] = bytes[sprite * 4 + 3];
+    }
+    if (copied.y == oam.y && copied.tile == oam.tile && copied.attributes == oam.attributes && copied.x == oam.x) {
+        return;
+    }
+    change_picture();
+    oam = copied;
+    sprite_lists_dirty = true;
+}
+
+void Ppu::build_sprite_lists() {
+    // See https://www.nesdev.org/wiki/PPU_sprite_evaluation
+    line_sprite_count.fill(0);
+    line_overflow.reset();
+    uint8_t height = sprite_height();
+    for (uint8_t sprite = 0; sprite < 64; sprite++) {
+        // Sprites are drawn one line below their Y coordinate.
+        uint16_t top = oam.y[sprite] + 1;
+        uint16_t bottom = std::min<uint16_t>(top + height, SCREEN_HEIGHT);
+        for (uint16_t line = top; line < bottom; line++) {
+            if (line_sprite_count[line] == 8) {
+                line_overflow[line] = true;
+            } else {
+                line_sprites[line][line_sprite_count[line]++] = sprite;
+            }
+        }
+    }
+    sprite_lists_dirty = false;
+}
+
+void Ppu::evaluate_sprites() {
+    if (sprite_lists_dirty) {
+        build_sprite_lists();
+    }
+    if (line_overflow[scanline]) {
+        status.set(PpuStatus::SpriteOverflow);
+    }
+
+    sprite_line.fill(0);
+    for (uint8_t i = 0; i < line_sprite_count[scanline]; i++) {
+        uint8_t sprite = line_sprites[scanline][i];
+        uint8_t attributes = oam.attributes[sprite];
+        uint8_t x = oam.x[sprite];
+        const uint8_t *pixels = pattern_row(sprite_pattern(sprite, scanline - oam.y[sprite] - 1));
+
+        uint8_t flags = 0x10 | ((attributes & 0x03) << 2);
+        if (attributes & 0x20) {
+            flags |= compositor::SpriteBehind;
+        }
+        if (sprite == 0) {
+            flags |= compositor::SpriteZero;
+        }
+        for (unsigned i = 0; i < 8 && x + i < SCREEN_WIDTH; i++) {
+            uint8_t pixel = pixels[(attributes & 0x40) ? 7 - i : i]; // flip horizontally
+            // Sprites earlier in OAM are drawn in front of later ones.
+            if (pixel && !(sprite_line[x + i] & compositor::SpriteColor)) {
+                sprite_line[x + i] = flags | pixel;
+            }
+        }
+    }
+}
+
+uint16_t Ppu::sprite_pattern(uint8_t sprite, int row) const {
+    uint8_t height = sprite_height();
+    uint8_t tile = oam.tile[sprite];
+    if (oam.attributes[sprite] & 0x80) {
+        row = height - 1 - row; // flip vertically
+    }
+    if (height == 16) {
+        // 8x16 sprites pick their pattern table with bit 0 of the tile.
+        return ((tile & 0x01) * 0x1000) + (tile & 0xFE) * 16 + (row & 0x08) * 2 + (row & 0x07);
+    }
+    return (control.is_set(PpuCtrl::SpriteTile) ? 0x1000 : 0) + tile * 16 + row;
+}
+
+void Ppu::compose(uint16_t first_x) {
+    std::array<uint8_t, SCREEN_WIDTH> colors;
+    int hit = compositor::compose(background_line.data(), sprite_line.data(), colors.data(), first_x, mask);
+    if (hit >= 0 && !sprite_zero_hit_dot && !status.is_set(PpuStatus::SpriteZeroHit)) {
+        sprite_zero_hit_dot = hit + 1;
+    }
+
+    // The composed colors never point at the mirrored palette entries, so
+    // they can index palette RAM directly. Grayscale works by dropping the
+    // low bits of the color, so it's applied here rather than by Palette.
+    uint8_t color_mask = mask.is_set(PpuMask::Grayscale) ? 0x30 : 0x3F;
+    uint16_t emphasis = (mask.get_value() & (PpuMask::EmphasizeRed | PpuMask::EmphasizeGreen |
+                                             PpuMask::EmphasizeBlue)) << 1;
+    uint16_t *out = &framebuffer[scanline * SCREEN_WIDTH];
+    for (uint16_t x = first_x; x < SCREEN_WIDTH; x++) {
+        out[x] = (palette_ram[colors[x]] & color_mask) | emphasis;
+    }
+}
+
+uint8_t Ppu::sprite_height() const {
+    return control.is_set(PpuCtrl::SpriteHeight) ? 16 : 8;
+}
+
+uint16_t Ppu::a12_rise_dot() const {
+    // Background tiles are fetched up to dot 256 and from dot 321, sprite
+    // tiles from dot 257, and A12 rises on the first fetch from $1000 after
+    // fetches from $0000. See https://www.nesdev.org/wiki/MMC3#IRQ_Specifics
+    bool background_high = control.is_set(PpuCtrl::BackgroundTile);
+    bool sprites_high = sprite_height() == 16 || control.is_set(PpuCtrl::SpriteTile);
+    if (!background_high && sprites_high) {
+        return 260;
+    }
+    if (background_high && !sprites_high) {
+        return 324;
+    }
+    return 0;
+}
+
+void Ppu::increment_y(LoopyRegister &address) {
+    if (address.get(LoopyRegister::FineY) < 7) {
+        address += 0x1000;
+        return;
+    }
+    address.set(LoopyRegister::FineY, 0);
+    uint8_t coarse_y = address.get(LoopyRegister::CoarseY);
+    if (coarse_y == 29) {
+        // Row 29 is the last row of tiles, the attribute table follows it.
+        coarse_y = 0;
+        address.set_value(address.get_value() ^ LoopyRegister::NametableY);
+    } else if (coarse_y == 31) {
+        coarse_y = 0;
+    } else {
+        coarse_y++;
+    }
+    address.set(LoopyRegister::CoarseY, coarse_y);
+}
+
+uint16_t Ppu::tile_address(const LoopyRegister &address, uint16_t column) {
+    LoopyRegister tile = address;
+    tile.set(LoopyRegister::CoarseX, column & 0x1F);
+    if (column & 0x20) {
+        tile.set_value(tile.get_value() ^ LoopyRegister::NametableX);
+    }
+    return tile.get_value();
+}
+
+void Ppu::copy_x() {
+    uint16_t bits = LoopyRegister::CoarseX | LoopyRegister::NametableX;
+    vram_address.set_value((vram_address.get_value() & ~bits) | (vram_address_temp.get_value() & bits));
+}
+
+void Ppu::copy_y() {
+    uint16_t bits = LoopyRegister::CoarseY | LoopyRegister::NametableY | LoopyRegister::FineY;
+    vram_address.set_value((vram_address.get_value() & ~bits) | (vram_address_temp.get_value() & bits));
+}
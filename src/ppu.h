@@ -2,21 +2,23 @@
 #define NES_PPU_H
 
 #include <array>
+#include <bitset>
 #include <cstdint>
 #include "registers/ppuctrl.h"
 #include "registers/ppumask.h"
 #include "registers/ppustatus.h"
 #include "registers/loopy.h"
+#include "region.h"
+
+class Cartridge;
 
 class Ppu {
 public:
+    static constexpr size_t SCREEN_WIDTH = 256;
+    static constexpr size_t SCREEN_HEIGHT = 240;
+
     Ppu();
     ~Ppu() = default;
-    struct Color {
-        uint8_t r, g, b;
-        Color() : r(0), g(0), b(0) {};
-        Color(uint8_t r, uint8_t g, uint8_t b) : r(r), g(g), b(b) {};
-    };
 
     uint8_t cpu_read(uint16_t address);
     void cpu_write(uint16_t address, uint8_t data);
@@ -24,6 +26,60 @@ public:
     void ppu_write(uint16_t address, uint8_t data);
     void clock();
     void reset();
+    void connect_cartridge(Cartridge *cartridge);
+    // Switch to the timing of the given region (NTSC by default).
+    void set_region(Region region);
+    // Point the nametables at the memory the cartridge currently maps them
+    // to, and redraw the background tiles whose CHR banks were switched. Called
+    // again whenever its mapper may have changed either.
+    void map_cartridge();
+    // Copy a page of sprite data into OAM, starting at OAMADDR the way OAM
+    // DMA does.
+    void write_oam(const uint8_t *data);
+
+    // Run the PPU until it has drawn the given number of dots since power
+    // on. The PPU is only caught up when something needs to see its state,
+    // so this usually covers many dots at once.
+    void run_until(uint64_t target_dot) { (this->*run_lines)(target_dot); }
+
+    // The dot count at which the PPU next changes state the CPU can see
+    // (entering or leaving vblank, a sprite 0 hit or sprite overflow). Valid
+    // until the next register write.
+    [[nodiscard]] uint64_t next_event();
+
+    // The dot count at which the current frame ends.
+    [[nodiscard]] uint64_t next_frame() const;
+
+    // The dot count at which the cartridge sees the nth scanline clock from
+    // now (see a12_rise_dot()), or UINT64_MAX if rendering is off or the
+    // pattern tables in use don't give one. Valid until the next register write.
+    [[nodiscard]] uint64_t next_scanline_clock(unsigned n) const;
+
+    // Whether the PPU has raised an NMI since the last call.
+    bool poll_nmi();
+    [[nodiscard]] bool is_nmi_pending() const { return nmi; }
+
+    [[nodiscard]] uint64_t get_dot_count() const { return dot_count; }
+    [[nodiscard]] uint64_t get_frame() const { return frame; }
+    // Whether the frame being drawn is the same as the last one, so its
+    // pixels aren't being drawn again (the framebuffer already has them).
+    [[nodiscard]] bool is_frame_repeated() const { return repeat_frame; }
+    // Whether any tiles of the background plane (or patterns they may be
+    // using) are waiting to be drawn again.
+    [[nodiscard]] bool is_background_dirty() const { return dirty_tiles.any() || dirty_patterns.any(); }
+
+    // Run frames for their timing only, from the start of the next frame.
+    // Vblank, NMIs, sprite 0 hit and sprite overflow all happen as usual,
+    // but nothing is drawn into the framebuffer. Meant for frames whose
+    // pixels would be thrown away anyway (frameskip, re-running frames).
+    void set_timing_only(bool timing_only) { skip_pixels = timing_only; }
+
+    // The picture drawn so far, one row of SCREEN_WIDTH pixels per scanline.
+    // Each pixel is a color index and emphasis bits, see Palette for how to
+    // turn them into RGB.
+    [[nodiscard]] const std::array<uint16_t, SCREEN_WIDTH * SCREEN_HEIGHT> &get_framebuffer() const {
+        return framebuffer;
+    }
 private:
     enum Registers {
         PPUCTRL = 0x2000,
@@ -42,10 +98,155 @@ private:
     PpuStatus status;
     LoopyRegister vram_address;
     LoopyRegister vram_address_temp;
-    uint8_t fine_x; // technically only 3 bits
-    uint8_t ppu_data_buffer;
-    bool write_toggle;
-    std::array<Color, 64> palette;
+    uint8_t fine_x = 0; // technically only 3 bits
+    uint8_t ppu_data_buffer = 0;
+    bool write_toggle = false;
+
+    // memory
+    Cartridge *cartridge = nullptr; // pattern tables
+    std::array<uint8_t, 2048> ciram{}; // internal VRAM, enough for two nametables
+    // Where each of the four logical nametables at $2000-$2FFF is stored.
+    // The cartridge decides, so changing the mirroring just swaps pointers.
+    std::array<uint8_t *, 4> nametables = {&ciram[0], &ciram[0], &ciram[0x400], &ciram[0x400]};
+    std::array<uint8_t, 32> palette_ram{};
+    uint8_t oam_address = 0;
+
+    // Object attribute memory, kept as an array for each field of the 64
+    // sprites rather than as 256 bytes, since sprite evaluation only looks
+    // at one field of most sprites.
+    struct Oam {
+        std::array<uint8_t, 64> y{};
+        std::array<uint8_t, 64> tile{};
+        std::array<uint8_t, 64> attributes{};
+        std::array<uint8_t, 64> x{};
+    } oam;
+
+    // The (up to 8) sprites on each visible scanline, and whether there were
+    // more. Built in one pass over OAM, and only again after OAM changes.
+    std::array<std::array<uint8_t, 8>, SCREEN_HEIGHT> line_sprites{};
+    std::array<uint8_t, SCREEN_HEIGHT> line_sprite_count{};
+    std::bitset<SCREEN_HEIGHT> line_overflow;
+    bool sprite_lists_dirty = true;
+
+    std::array<uint16_t, SCREEN_WIDTH * SCREEN_HEIGHT> framebuffer{};
+
+    // All four nametables drawn out as background pixels (as described in
+    // compositor.h), so that most scanlines can just be copied out of it at
+    // the scroll position. Only tiles whose nametable, attribute or pattern
+    // bytes changed are drawn again.
+    static constexpr size_t PLANE_WIDTH = SCREEN_WIDTH * 2;
+    static constexpr size_t PLANE_HEIGHT = SCREEN_HEIGHT * 2;
+    static constexpr uint16_t PLANE_TILES_PER_TABLE = 32 * 30;
+    std::array<uint8_t, PLANE_WIDTH * PLANE_HEIGHT> background_plane{};
+    std::bitset<PLANE_TILES_PER_TABLE * 4> dirty_tiles = std::bitset<PLANE_TILES_PER_TABLE * 4>().set();
+    std::bitset<512> dirty_patterns; // by pattern table address / 16
+    std::array<uint32_t, 8> chr_banks{}; // the cartridge's CHR banks the plane was drawn from
+
+    // rendering
+    // Each visible scanline is drawn in one go as the PPU starts it, from
+    // the VRAM address and fine X scroll at that point. If the CPU writes a
+    // PPU register part way through the line, the rest of it is redrawn a
+    // dot at a time from where the PPU has got to.
+    //
+    // The pixels are kept as described in compositor.h.
+    std::array<uint8_t, SCREEN_WIDTH> background_line{};
+    std::array<uint8_t, SCREEN_WIDTH> sprite_line{};
+    LoopyRegister line_address; // VRAM address the background is drawn from
+    uint16_t line_start_x = 0;  // pixel drawn from the start of line_address
+    uint16_t sprite_zero_hit_dot = 0; // dot sprite 0 hits on this line (0 if it doesn't)
+
+    // A frame is only drawn if something that affects the picture changed
+    // since the last one started: the contents of VRAM, OAM or the palette,
+    // the registers it starts from, or any register written while the
+    // visible lines were being drawn (a raster effect). Otherwise the last
+    // frame's pixels are kept, and only its sprite 0 hit and overflow are
+    // replayed.
+    struct FrameState {
+        uint16_t address;
+        uint8_t control;
+        uint8_t mask;
+        uint8_t fine_x;
+        bool operator==(const FrameState &) const = default;
+    };
+    FrameState frame_state{};
+    bool picture_changed = true;
+    bool repeat_frame = false;
+    bool skip_pixels = false; // set by the host for the next frame
+    bool timing_only = false; // for the frame being drawn
+    uint16_t frame_hit_line = 0; // where sprite 0 hit in the last frame drawn
+    uint16_t frame_hit_dot = 0;  // (0 if it didn't)
+
+    RegionTiming timing = NTSC_TIMING;
+    // run_lines_for() compiled for the region's timing.
+    void (Ppu::*run_lines)(uint64_t target_dot) = nullptr;
+
+    uint64_t dot_count = 0; // dots drawn since power on
+    uint64_t frame = 0;     // frames drawn since power on
+    uint16_t scanline = 0;  // 0-239 visible, 240 post-render, 241-260 vblank, 261 pre-render
+    uint16_t dot = 0;       // next dot to be drawn on the scanline
+    bool nmi = false;
+
+    // Number of dots on a scanline (the pre-render line is one dot short on
+    // odd frames while rendering is enabled).
+    [[nodiscard]] uint16_t scanline_length(const RegionTiming &region, uint16_t line) const;
+    template<RegionTiming T>
+    void run_lines_for(uint64_t target_dot);
+    [[nodiscard]] bool rendering_enabled() const;
+    // Dots from the current position until the given scanline and dot.
+    [[nodiscard]] uint64_t dots_until(uint16_t line, uint16_t line_dot) const;
+    // Work out the line and dot of the next sprite 0 hit from the opaque
+    // pixels of sprite 0 and the background under it, assuming nothing is
+    // written to the PPU in the meantime. Returns false if there won't be
+    // one this frame.
+    bool predict_sprite_zero_hit(uint16_t &hit_line, uint16_t &hit_dot);
+    // The dot sprite 0 hits on for a line drawn from the address (0 if it
+    // doesn't).
+    uint16_t sprite_zero_line_hit(const LoopyRegister &address, uint16_t line);
+    // Which of the 8 background pixels from x are opaque (bit 7 for x).
+    uint8_t background_opacity(LoopyRegister address, uint16_t x);
+    // Decide whether the frame that's starting can reuse the last one.
+    void start_frame();
+    // Note a change to something the picture is drawn from. Must be called
+    // before the change is made, since the current line may need drawing.
+    void change_picture();
+    void start_vblank();
+    void end_vblank();
+
+    void render_scanline();
+    void render_from(uint16_t x);
+    // Decode the 8 background pixels of the tile at the VRAM address.
+    void fetch_tile(uint16_t address, uint8_t *pixels);
+    // The decoded pixels of the pattern table row at the address.
+    const uint8_t *pattern_row(uint16_t address);
+    // Mark the background plane tiles a nametable write at the address
+    // affects as needing to be drawn again.
+    void mark_background_dirty(uint16_t address);
+    void update_background_plane();
+    [[nodiscard]] uint8_t oam_read(uint8_t address) const;
+    void oam_write(uint8_t address, uint8_t data);
+    void build_sprite_lists();
+    void evaluate_sprites();
+    // Pattern table address of the given row of a sprite.
+    [[nodiscard]] uint16_t sprite_pattern(uint8_t sprite, int row) const;
+    void compose(uint16_t first_x);
+    [[nodiscard]] uint8_t sprite_height() const;
+    // The dot PPU address line A12 rises on during each rendered line, which
+    // is what mappers like the MMC3 count scanlines with. It rises once a line
+    // when the background and sprites use different pattern tables (or with
+    // 8x16 sprites, which are always fetched from $1000 in practice), and not
+    // at all otherwise (0). This only models the pattern fetches, not A12
+    // toggled through PPUADDR.
+    [[nodiscard]] uint16_t a12_rise_dot() const;
+
+    // Scrolling during rendering, see https://www.nesdev.org/wiki/PPU_scrolling
+    static void increment_y(LoopyRegister &address);
+    // VRAM address of a column of tiles (0-63, counting on into the next
+    // nametable) on the address's row.
+    static uint16_t tile_address(const LoopyRegister &address, uint16_t column);
+    void copy_x();
+    void copy_y();
+
+    static uint16_t palette_index(uint16_t address);
 };
 
 
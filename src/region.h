@@ -0,0 +1,50 @@
+#ifndef NES_REGION_H
+#define NES_REGION_H
+
+
+#include <cstdint>
+
+// The consoles sold in each region run the same chips at different speeds.
+// See https://www.nesdev.org/wiki/Cycle_reference_chart
+enum class Region : uint8_t {
+    NTSC,
+    PAL,
+    Dendy, // a PAL famiclone, timed so NTSC games run at the right speed
+};
+
+// The timing of one region. The PPU's scanline loop takes this as a template
+// parameter, so it's compiled once for each region with the numbers folded
+// in. Everything else just reads it at run time.
+struct RegionTiming {
+    uint32_t master_clock;                // Hz
+    uint8_t master_cycles_per_cpu_cycle;
+    uint8_t master_cycles_per_ppu_dot;
+    uint16_t scanlines_per_frame;         // including the pre-render line
+    uint16_t vblank_scanline;             // vblank starts on dot 1 of this line
+    bool short_odd_frames;                // odd frames skip a dot while rendering
+
+    [[nodiscard]] constexpr uint16_t pre_render_scanline() const {
+        return scanlines_per_frame - 1;
+    }
+
+    [[nodiscard]] constexpr double frames_per_second() const {
+        return static_cast<double>(master_clock) / (master_cycles_per_ppu_dot * 341.0 * scanlines_per_frame);
+    }
+};
+
+//@formatter:off
+constexpr RegionTiming NTSC_TIMING  {21477272, 12, 4, 262, 241, true};
+constexpr RegionTiming PAL_TIMING   {26601712, 16, 5, 312, 241, false};
+constexpr RegionTiming DENDY_TIMING {26601712, 15, 5, 312, 291, false};
+//@formatter:on
+
+constexpr const RegionTiming &region_timing(Region region) {
+    switch (region) {
+        case Region::PAL:   return PAL_TIMING;
+        case Region::Dendy: return DENDY_TIMING;
+        default:            return NTSC_TIMING;
+    }
+}
+
+
+#endif //NES_REGION_H
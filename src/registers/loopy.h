@@ -6,7 +6,7 @@
 
 // Used for the "Loopy" registers inside the PPU (Current VRAM address and Temporary VRAM address)
 // See https://www.nesdev.org/wiki/PPU_scrolling#PPU_internal_registers
-class LoopyRegister : public Register<uint16_t> {
+class LoopyRegister final : public Register<uint16_t> {
 public:
     // yyy NN YYYYY XXXXX
     // ||| || ||||| +++++-- coarse X scroll
@@ -6,55 +6,64 @@
 #include <cstdint>
 #include "../utils.h"
 
+// Base class for the CPU and PPU registers. Nothing here is virtual and
+// everything is constexpr, so when the flag is a constant (as it always is
+// for the named flags of each register) the masks and shifts are worked out
+// at compile time, e.g. LoopyRegister::set(CoarseX, data) compiles down to a
+// mask, a shift and an or. Subclasses that need different behaviour hide the
+// methods they change (see StatusRegister) and should be marked final.
 template<typename T>
 class Register {
 public:
 
-    Register(): Register(0) {};
+    constexpr Register(): Register(0) {};
 
-    explicit Register(T value) {
+    constexpr explicit Register(T value) {
         this->value = value;
     }
 
-    virtual ~Register() = default;
+    // The number of bits the value of a flag is shifted by.
+    static constexpr uint8_t shift(T flag) {
+        return utils::count_trailing_zeroes(flag);
+    }
 
     // Get the full status register value.
-    [[nodiscard]] virtual T get_value() const {
+    [[nodiscard]] constexpr T get_value() const {
         return value;
     }
 
     // Set the full status register value.
-    virtual void set_value(T v) {
+    constexpr void set_value(T v) {
         value = v;
     }
 
     // Set a specific flag.
-    virtual void set(T flag) {
+    constexpr void set(T flag) {
         value |= flag;
     }
 
     // Get a specific flag.
-    virtual uint8_t get(T flag) {
-        return ((value & flag) >> utils::count_trailing_zeroes(flag));
+    constexpr uint8_t get(T flag) {
+        return ((value & flag) >> shift(flag));
     }
 
     // Clear (disable) a flag on the status register.
-    virtual void clear(T flag) {
+    constexpr void clear(T flag) {
         value &= ~flag;
     }
 
     // Set the flag if the condition is true, otherwise, clear the flag.
-    virtual void set_if(T flag, bool condition) {
+    constexpr void set_if(T flag, bool condition) {
         if (condition) {
-            set_value(flag);
+            set(flag);
         } else {
             clear(flag);
         }
     }
 
-    virtual void set(T flag, T data) {
+    constexpr void set(T flag, T data) {
         // Shift the data by the number of trailing zeroes for this flag.
-        data <<= utils::count_trailing_zeroes(flag);
+        data <<= shift(flag);
 
         // Mask the data with the flag to ensure we don't modify any
         // bits outside the flag.
@@ -70,44 +79,44 @@ public:
     // TODO: Figure out how to overload = to set value. No matter what I try, I keep getting "no viable overloaded '='"
     // Use .set_value() for now
 
-    virtual Register<T> &operator=(const T &data) {
+    constexpr Register<T> &operator=(const T &data) {
         value = data;
         return *this;
     }
 
-    virtual Register<T> &operator+=(const T &data) {
+    constexpr Register<T> &operator+=(const T &data) {
         value += data;
         return *this;
     }
 
-    virtual Register<T> &operator-=(const T &data) {
+    constexpr Register<T> &operator-=(const T &data) {
         value -= data;
         return *this;
     }
 
-    virtual bool operator>=(const T &data) {
+    constexpr bool operator>=(const T &data) {
         return value >= data;
     }
 
-    virtual bool operator<=(const T &data) {
+    constexpr bool operator<=(const T &data) {
         return value <= data;
     }
 
-    virtual bool operator==(const T &data) {
+    constexpr bool operator==(const T &data) {
         return value == data;
     }
 
-    virtual bool operator!=(const T &data) {
+    constexpr bool operator!=(const T &data) {
         return value != data;
     }
 
     // Check if the flag is set.
-    [[nodiscard]] virtual bool is_set(T flag) const {
+    [[nodiscard]] constexpr bool is_set(T flag) const {
         return (value & flag) == flag;
     }
 
     // Check if the flag is clear.
-    [[nodiscard]] virtual bool is_clear(T flag) const {
+    [[nodiscard]] constexpr bool is_clear(T flag) const {
         return !is_set(flag);
     }
 
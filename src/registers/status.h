@@ -6,7 +6,13 @@
 #include "register.h"
 
 // Status register for the CPU.
-class StatusRegister : public Register<uint8_t> {
+//
+// The Carry, Zero, Negative, and Overflow flags are evaluated lazily. Most
+// instructions overwrite them long before a branch, PHP, or interrupt looks
+// at them, so instead of updating the flags on every instruction we keep
+// the result they are derived from and only work out the flag when it is
+// actually read.
+class StatusRegister final : public Register<uint8_t> {
 public:
     //@formatter:off
     // Flags for the status register
@@ -22,13 +28,95 @@ public:
     };
     //@formatter:on
 
-    // Set default flags based on the provided data.
-    void set_defaults(uint8_t flags, uint16_t data);
+    // Set default flags (Carry, Zero, and/or Negative) based on the provided
+    // data. Carry is set when the data overflowed a byte, Zero when the low
+    // byte is zero, and Negative when bit 7 is set.
+    void set_defaults(uint8_t flags, uint16_t data) {
+        if (flags & Carry) {
+            carry_result = data;
+            lazy |= Carry;
+        }
+        if (flags & (Zero | Negative)) {
+            // Zero and Negative share a result, so if only one of them is
+            // being replaced the other has to be worked out first.
+            materialize(lazy & (Zero | Negative) & ~flags);
+            zero_negative_result = data;
+            lazy |= flags & (Zero | Negative);
+        }
+    }
+
+    // Set the Overflow flag from bit 7 of the provided data.
+    void set_overflow(uint8_t data) {
+        overflow_result = data;
+        lazy |= Overflow;
+    }
 
     // Override for setting the value (unused should always be set to 1
     // for the status register so we'll ensure that in the override).
-    void set_value(uint8_t v) override;
+    void set_value(uint8_t v);
+
+    [[nodiscard]] uint8_t get_value() const {
+        return (value & ~lazy) | evaluate(lazy);
+    }
+
+    void set(uint8_t flag) {
+        value |= flag;
+        lazy &= ~flag;
+    }
+
+    uint8_t get(uint8_t flag) {
+        materialize(flag);
+        return Register::get(flag);
+    }
+
+    void clear(uint8_t flag) {
+        value &= ~flag;
+        lazy &= ~flag;
+    }
+
+    void set_if(uint8_t flag, bool condition) {
+        if (condition) {
+            set(flag);
+        } else {
+            clear(flag);
+        }
+    }
+
+    void set(uint8_t flag, uint8_t data) {
+        lazy &= ~flag;
+        Register::set(flag, data);
+    }
+
+    [[nodiscard]] bool is_set(uint8_t flag) const {
+        return (get_value() & flag) == flag;
+    }
+
+    [[nodiscard]] bool is_clear(uint8_t flag) const {
+        return !is_set(flag);
+    }
+
 private:
+    uint8_t lazy = 0; // flags that still have to be evaluated from the results below
+    uint16_t carry_result = 0;
+    uint16_t zero_negative_result = 0;
+    uint8_t overflow_result = 0;
+
+    // Evaluate the given lazy flags from the results they were recorded with.
+    [[nodiscard]] uint8_t evaluate(uint8_t flags) const {
+        uint8_t result = 0;
+        if ((flags & Carry) && carry_result > 0xFF) result |= Carry;
+        if ((flags & Zero) && (zero_negative_result & 0xFF) == 0) result |= Zero;
+        if ((flags & Negative) && (zero_negative_result & 0x80)) result |= Negative;
+        if ((flags & Overflow) && (overflow_result & 0x80)) result |= Overflow;
+        return result;
+    }
+
+    // Write the given lazy flags into the register value.
+    void materialize(uint8_t flags) {
+        flags &= lazy;
+        value = (value & ~flags) | evaluate(flags);
+        lazy &= ~flags;
+    }
 };
 
 
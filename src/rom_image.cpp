@@ -0,0 +1,80 @@
+#include "rom_image.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <mutex>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+std::shared_ptr<const RomImage> RomImage::map_file(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) < 0) {
+        close(fd);
+        return nullptr;
+    }
+    if (info.st_size == 0) {
+        // Empty files can't be mapped.
+        close(fd);
+        return copy({});
+    }
+
+    // The mapping stays valid after the file is closed.
+    size_t size = info.st_size;
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    std::shared_ptr<RomImage> image(new RomImage());
+    image->mapping = mapping;
+    image->contents = {static_cast<const uint8_t *>(mapping), size};
+    return share(image->bytes(), [&image] { return image; });
+}
+
+std::shared_ptr<const RomImage> RomImage::copy(std::span<const uint8_t> bytes) {
+    // Only copy the bytes if they aren't loaded already.
+    return share(bytes, [bytes] {
+        std::shared_ptr<RomImage> image(new RomImage());
+        image->memory.assign(bytes.begin(), bytes.end());
+        image->contents = image->memory;
+        return image;
+    });
+}
+
+RomImage::~RomImage() {
+    if (mapping) {
+        munmap(mapping, contents.size());
+    }
+}
+
+std::shared_ptr<const RomImage> RomImage::share(std::span<const uint8_t> bytes,
+                                                const std::function<std::shared_ptr<const RomImage>()> &create) {
+    // Images are only kept alive by the cartridges using them.
+    static std::mutex mutex;
+    static std::unordered_multimap<size_t, std::weak_ptr<const RomImage>> registry;
+
+    std::string_view contents(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    size_t hash = std::hash<std::string_view>{}(contents);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [first, last] = registry.equal_range(hash);
+    for (auto it = first; it != last;) {
+        std::shared_ptr<const RomImage> loaded = it->second.lock();
+        if (!loaded) {
+            it = registry.erase(it);
+        } else if (std::ranges::equal(loaded->bytes(), bytes)) {
+            return loaded;
+        } else {
+            ++it;
+        }
+    }
+    std::shared_ptr<const RomImage> image = create();
+    registry.emplace(hash, image);
+    return image;
+}
@@ -0,0 +1,48 @@
+#ifndef NES_ROM_IMAGE_H
+#define NES_ROM_IMAGE_H
+
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+// The read-only bytes of a ROM file, shared by every cartridge loaded from
+// the same contents.
+//
+// Files are mapped into memory rather than read, so the OS pages ROM in as
+// it's used and every mapping of a file shares the same physical pages.
+// Images are also looked up by a hash of their contents, so cartridges
+// loaded from copies of a ROM (or from bytes the caller already had) still
+// end up sharing one image.
+class RomImage {
+public:
+    // The image of the file at the path, or nullptr if it can't be opened.
+    static std::shared_ptr<const RomImage> map_file(const std::string &path);
+
+    // The image of the given bytes, copying them if nothing already loaded
+    // has the same contents.
+    static std::shared_ptr<const RomImage> copy(std::span<const uint8_t> bytes);
+
+    RomImage(const RomImage &) = delete;
+    RomImage &operator=(const RomImage &) = delete;
+    ~RomImage();
+
+    [[nodiscard]] std::span<const uint8_t> bytes() const { return contents; }
+private:
+    RomImage() = default;
+
+    std::span<const uint8_t> contents;
+    void *mapping = nullptr;     // the file mapping, if the image is one
+    std::vector<uint8_t> memory; // the copy of the bytes, if it isn't
+
+    // The loaded image with the given contents if there is one, otherwise
+    // the one made by create(), which is added to the registry.
+    static std::shared_ptr<const RomImage> share(std::span<const uint8_t> bytes,
+                                                 const std::function<std::shared_ptr<const RomImage>()> &create);
+};
+
+
+#endif //NES_ROM_IMAGE_H
@@ -0,0 +1,221 @@
+#include "rom_index.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <thread>
+#include "hash.h"
+#include "log.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    // The index is a cache for the machine it's built on, so fields are
+    // written in host byte order.
+    const char MAGIC[8] = {'N', 'E', 'S', 'R', 'O', 'M', 'D', 'B'};
+    const uint32_t FORMAT_VERSION = 1;
+
+    template<typename T>
+    void put(std::ostream &out, T value) {
+        out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    template<typename T>
+    T get(std::istream &in) {
+        T value{};
+        in.read(reinterpret_cast<char *>(&value), sizeof(value));
+        return value;
+    }
+
+    std::string canonical_path(const std::string &path) {
+        std::error_code error;
+        fs::path canonical = fs::weakly_canonical(path, error);
+        return error ? path : canonical.string();
+    }
+
+    // The size and modification time of the file, or false if it can't be
+    // read.
+    bool file_stamp(const std::string &path, uint64_t &size, int64_t &modified) {
+        std::error_code error;
+        size = fs::file_size(path, error);
+        if (error) {
+            return false;
+        }
+        modified = fs::last_write_time(path, error).time_since_epoch().count();
+        return !error;
+    }
+
+    // Read, check and hash a ROM file.
+    std::optional<RomIndex::Entry> index_file(const std::string &path, uint64_t size, int64_t modified,
+                                              const HeaderDatabase &database) {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<uint8_t> image(size);
+        if (!file.read(reinterpret_cast<char *>(image.data()), image.size())) {
+            return std::nullopt;
+        }
+        RomIndex::Entry entry{path, size, modified, 0, {}, false, {}};
+        if (!RomInfo::parse(image, entry.info)) {
+            return std::nullopt;
+        }
+        std::span<const uint8_t> rom = entry.info.rom(image);
+        entry.crc32 = hash::crc32(rom);
+        entry.sha1 = hash::sha1(rom);
+        entry.corrected = database.find(entry.crc32) != nullptr;
+        database.correct(entry.crc32, entry.info);
+        return entry;
+    }
+}
+
+bool RomIndex::load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC) ||
+        get<uint32_t>(file) != FORMAT_VERSION) {
+        LOG_ERROR("Could not read ROM index at path " << path)
+        return false;
+    }
+
+    entries.clear();
+    by_path.clear();
+    auto count = get<uint32_t>(file);
+    for (uint32_t i = 0; i < count && file; i++) {
+        Entry entry{};
+        entry.path.resize(get<uint16_t>(file));
+        file.read(entry.path.data(), entry.path.size());
+        entry.file_size = get<uint64_t>(file);
+        entry.modified = get<int64_t>(file);
+        entry.crc32 = get<uint32_t>(file);
+        file.read(reinterpret_cast<char *>(entry.sha1.data()), entry.sha1.size());
+        entry.corrected = get<uint8_t>(file);
+        entry.info.mapper = get<uint16_t>(file);
+        entry.info.mirror = static_cast<Mapper::Mirror>(get<uint8_t>(file));
+        entry.info.region = static_cast<Region>(get<uint8_t>(file));
+        entry.info.version = get<uint8_t>(file);
+        entry.info.battery = get<uint8_t>(file);
+        entry.info.prg_rom_offset = get<uint32_t>(file);
+        entry.info.prg_rom_size = get<uint32_t>(file);
+        entry.info.chr_rom_size = get<uint32_t>(file);
+        entry.info.prg_ram_size = get<uint32_t>(file);
+        add(std::move(entry));
+    }
+    if (!file) {
+        LOG_ERROR("ROM index at path " << path << " is truncated")
+        entries.clear();
+        by_path.clear();
+        return false;
+    }
+    return true;
+}
+
+bool RomIndex::save(const std::string &path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(MAGIC, sizeof(MAGIC));
+    put<uint32_t>(file, FORMAT_VERSION);
+    put<uint32_t>(file, entries.size());
+    for (const Entry &entry: entries) {
+        put<uint16_t>(file, entry.path.size());
+        file.write(entry.path.data(), entry.path.size());
+        put<uint64_t>(file, entry.file_size);
+        put<int64_t>(file, entry.modified);
+        put<uint32_t>(file, entry.crc32);
+        file.write(reinterpret_cast<const char *>(entry.sha1.data()), entry.sha1.size());
+        put<uint8_t>(file, entry.corrected);
+        put<uint16_t>(file, entry.info.mapper);
+        put<uint8_t>(file, entry.info.mirror);
+        put<uint8_t>(file, static_cast<uint8_t>(entry.info.region));
+        put<uint8_t>(file, entry.info.version);
+        put<uint8_t>(file, entry.info.battery);
+        put<uint32_t>(file, entry.info.prg_rom_offset);
+        put<uint32_t>(file, entry.info.prg_rom_size);
+        put<uint32_t>(file, entry.info.chr_rom_size);
+        put<uint32_t>(file, entry.info.prg_ram_size);
+    }
+    if (!file) {
+        LOG_ERROR("Could not write ROM index to path " << path)
+        return false;
+    }
+    return true;
+}
+
+RomIndex::ScanStats RomIndex::scan(const std::vector<std::string> &directories, const HeaderDatabase &database,
+                                   unsigned threads) {
+    std::vector<std::string> paths;
+    for (const std::string &directory: directories) {
+        std::error_code error;
+        for (auto it = fs::recursive_directory_iterator(directory, error); !error && it != fs::end(it);
+             it.increment(error)) {
+            std::string extension = it->path().extension().string();
+            if (it->is_regular_file() && (extension == ".nes" || extension == ".NES")) {
+                paths.push_back(canonical_path(it->path().string()));
+            }
+        }
+        if (error) {
+            LOG_ERROR("Could not scan directory " << directory << ": " << error.message())
+        }
+    }
+
+    // Each thread takes the next file until they're all done. Unchanged
+    // files are copied from the old entries, which are only read here.
+    std::vector<std::optional<Entry>> results(paths.size());
+    std::atomic<size_t> next = 0;
+    std::atomic<size_t> read = 0;
+    auto work = [&]() {
+        for (size_t i = next++; i < paths.size(); i = next++) {
+            uint64_t size;
+            int64_t modified;
+            if (!file_stamp(paths[i], size, modified)) {
+                continue;
+            }
+            auto old = by_path.find(paths[i]);
+            if (old != by_path.end() && entries[old->second].file_size == size &&
+                entries[old->second].modified == modified) {
+                results[i] = entries[old->second];
+                continue;
+            }
+            read++;
+            results[i] = index_file(paths[i], size, modified, database);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < std::max(threads, 1u); i++) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread &worker: workers) {
+        worker.join();
+    }
+
+    ScanStats stats{paths.size(), read, 0, 0};
+    entries.clear();
+    by_path.clear();
+    for (std::optional<Entry> &result: results) {
+        if (!result) {
+            stats.invalid++;
+            continue;
+        }
+        stats.corrected += result->corrected;
+        add(std::move(*result));
+    }
+    return stats;
+}
+
+const RomIndex::Entry *RomIndex::find(const std::string &path) const {
+    std::string canonical = canonical_path(path);
+    auto it = by_path.find(canonical);
+    if (it == by_path.end()) {
+        return nullptr;
+    }
+    const Entry &entry = entries[it->second];
+    uint64_t size;
+    int64_t modified;
+    if (!file_stamp(canonical, size, modified) || size != entry.file_size || modified != entry.modified) {
+        return nullptr;
+    }
+    return &entry;
+}
+
+void RomIndex::add(Entry entry) {
+    by_path[entry.path] = entries.size();
+    entries.push_back(std::move(entry));
+}
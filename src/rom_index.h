@@ -0,0 +1,60 @@
+#ifndef NES_ROM_INDEX_H
+#define NES_ROM_INDEX_H
+
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "header_database.h"
+#include "rom_info.h"
+
+// An on-disk index of a ROM library: each ROM's checksums and its header
+// info, already validated and corrected against a HeaderDatabase. Loading
+// a ROM with its indexed info (see Cartridge::load) skips the header, and
+// rescanning the library only reads files that changed since the last scan.
+class RomIndex {
+public:
+    struct Entry {
+        std::string path;     // canonical
+        uint64_t file_size;   // of the file when it was indexed, to tell
+        int64_t modified;     // whether it's changed since
+        uint32_t crc32;       // of PRG-ROM and CHR-ROM
+        std::array<uint8_t, 20> sha1;
+        bool corrected;       // the header info came from the database
+        RomInfo info;
+    };
+
+    // Results of the last scan.
+    struct ScanStats {
+        size_t files;     // ROM files found
+        size_t read;      // files that had to be read (new or changed)
+        size_t invalid;   // files that weren't valid ROM images
+        size_t corrected; // ROMs with a header correction
+    };
+
+    // Replace the index with the file written by save(). Returns false if
+    // it can't be read.
+    bool load(const std::string &path);
+    bool save(const std::string &path) const;
+
+    // Index every .nes file under the directories, reading and hashing them
+    // on the given number of threads. Entries for files that haven't
+    // changed are kept without reading them again, and entries for files
+    // that are gone are dropped.
+    ScanStats scan(const std::vector<std::string> &directories, const HeaderDatabase &database, unsigned threads);
+
+    // The entry for the ROM file at the path, or nullptr if it isn't indexed
+    // or has changed since it was.
+    [[nodiscard]] const Entry *find(const std::string &path) const;
+    [[nodiscard]] const std::vector<Entry> &get_entries() const { return entries; }
+private:
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, size_t> by_path;
+
+    void add(Entry entry);
+};
+
+
+#endif //NES_ROM_INDEX_H
@@ -0,0 +1,116 @@
+#include "rom_info.h"
+#include <algorithm>
+#include <cstring>
+#include "log.h"
+
+namespace {
+    // see https://www.nesdev.org/wiki/INES and https://www.nesdev.org/wiki/NES_2.0
+    struct Header {
+        char constant[4];     // ASCII "NES" followed by MS-DOS EOF (0x1A)
+        uint8_t prg_rom_size; // Size of PRG ROM in 16 KB units
+        uint8_t chr_rom_size; // Size of CHR ROM in 8 KB units
+        uint8_t flags6;       // Mapper, mirroring, battery, trainer
+        uint8_t flags7;       // Mapper, VS/Playchoice, NES 2.0
+        uint8_t flags8;       // PRG-RAM size (iNES), mapper bits 8-11 (NES 2.0)
+        uint8_t flags9;       // TV system (iNES), ROM size high bits (NES 2.0)
+        uint8_t flags10;      // TV system, PRG-RAM presence (unofficial), PRG-RAM size (NES 2.0)
+        uint8_t flags11;      // NES 2.0 CHR-RAM size
+        uint8_t flags12;      // NES 2.0 CPU/PPU timing (region)
+        uint8_t padding[3];   // Unused padding
+    };
+
+    enum Flags6 {
+        Mirroring = 1 << 0,       // Mirroring enabled, horizontal or vertical
+        HasPrgRam = 1 << 1,       // Cartridge has PRG RAM ($6000-7FFF) or other persistent memory
+        Trainer = 1 << 2,         // Trainer exists
+        IgnoreMirroring = 1 << 3, // Ignore mirroring, provide four-screen VRAM
+    };
+
+    enum Flags7 {
+        VSUnisystem = 1 << 0,
+        PlayChoice10 = 1 << 1,
+        Nes2FormatA = 1 << 2,
+        Nes2FormatB = 1 << 3,
+    };
+
+    bool has_flag(uint8_t flags, uint8_t flag) {
+        return (flags & flag) == flag;
+    }
+}
+
+bool RomInfo::parse(std::span<const uint8_t> image, RomInfo &info) {
+    Header header{};
+    if (image.size() < sizeof(header)) {
+        LOG_ERROR("Could not read iNES header from ROM!")
+        return false;
+    }
+    std::memcpy(&header, image.data(), sizeof(header));
+
+    if (header.constant[0] != 'N' || header.constant[1] != 'E' || header.constant[2] != 'S' ||
+        header.constant[3] != '\x1A') {
+        LOG_ERROR("iNES header is not in valid format. Possibly a different format?")
+        LOG_ERROR("Expected: 4e 45 53 1a")
+        LOG_ERROR("Got:      " << std::hex << unsigned(header.constant[0]) << " " << unsigned(header.constant[1]) << " "
+                               << unsigned(header.constant[2]) << " " << unsigned(header.constant[3]))
+        return false;
+    }
+
+    // NES 2.0 headers have 0b10 in bits 2-3 of flags 7.
+    info.version = (header.flags7 & (Nes2FormatA | Nes2FormatB)) == Nes2FormatB ? 2 : 1;
+
+    // The upper half of flags 6 and 7 make up the mapper ID, and NES 2.0
+    // adds 4 more bits.
+    info.mapper = header.flags6 >> 4 | (header.flags7 & 0xF0);
+    uint32_t prg_banks = header.prg_rom_size;
+    uint32_t chr_banks = header.chr_rom_size;
+    if (info.version == 2) {
+        info.mapper |= (header.flags8 & 0x0F) << 8;
+        // The high bits of the ROM sizes. 0xF means the size is given as an
+        // exponent instead, which only odd-sized homebrew uses.
+        if ((header.flags9 & 0x0F) == 0x0F || (header.flags9 >> 4) == 0x0F) {
+            LOG_ERROR("Exponent-multiplier ROM sizes are not supported!")
+            return false;
+        }
+        prg_banks |= (header.flags9 & 0x0F) << 8;
+        chr_banks |= (header.flags9 >> 4) << 8;
+    }
+    if (prg_banks == 0) {
+        LOG_ERROR("Cartridge has no PRG-ROM!")
+        return false;
+    }
+
+    if (has_flag(header.flags6, IgnoreMirroring)) {
+        info.mirror = Mapper::FourScreen;
+    } else {
+        info.mirror = has_flag(header.flags6, Mirroring) ? Mapper::Vertical : Mapper::Horizontal;
+    }
+    info.battery = has_flag(header.flags6, HasPrgRam);
+
+    if (info.version == 2) {
+        // 0: NTSC, 1: PAL, 2: either (we pick NTSC), 3: Dendy
+        uint8_t timing = header.flags12 & 0x03;
+        info.region = timing == 1 ? Region::PAL : timing == 3 ? Region::Dendy : Region::NTSC;
+        // Volatile and battery-backed PRG-RAM, each as a shift count of 64
+        // bytes (0 for none).
+        uint8_t ram = header.flags10 & 0x0F;
+        uint8_t nvram = header.flags10 >> 4;
+        info.prg_ram_size = (ram ? 64u << ram : 0) + (nvram ? 64u << nvram : 0);
+    } else {
+        info.region = has_flag(header.flags9, 1) ? Region::PAL : Region::NTSC;
+        // In 8KB units, where 0 also means 8KB for compatibility.
+        info.prg_ram_size = std::max<uint32_t>(header.flags8, 1) * 0x2000;
+    }
+
+    info.prg_rom_offset = sizeof(header);
+    if (has_flag(header.flags6, Trainer)) {
+        // Skip the 512-byte trainer if it exists
+        info.prg_rom_offset += 512;
+    }
+    info.prg_rom_size = prg_banks * 0x4000;
+    info.chr_rom_size = chr_banks * 0x2000;
+    if (image.size() < info.prg_rom_offset + info.prg_rom_size + info.chr_rom_size) {
+        LOG_ERROR("ROM is smaller than its header says!")
+        return false;
+    }
+    return true;
+}
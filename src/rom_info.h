@@ -0,0 +1,37 @@
+#ifndef NES_ROM_INFO_H
+#define NES_ROM_INFO_H
+
+
+#include <cstdint>
+#include <span>
+#include "mappers/mapper.h"
+#include "region.h"
+
+// What a ROM image's header says about the cartridge. It's worked out once
+// from the header, and can then be corrected (see HeaderDatabase) and
+// cached (see RomIndex) so loading doesn't have to trust the header.
+struct RomInfo {
+    uint16_t mapper = 0;
+    Mapper::Mirror mirror = Mapper::Horizontal;
+    Region region = Region::NTSC;
+    uint8_t version = 1;         // iNES (1) or NES 2.0 (2)
+    bool battery = false;        // PRG-RAM is battery backed
+    uint32_t prg_rom_offset = 0; // after the header and any trainer
+    uint32_t prg_rom_size = 0;   // in bytes
+    uint32_t chr_rom_size = 0;   // in bytes, 0 for CHR-RAM
+    uint32_t prg_ram_size = 0;   // in bytes
+
+    // Read the info from the header of an iNES or NES 2.0 image, checking
+    // the image is as big as the header says. Returns false if it isn't a
+    // valid image.
+    static bool parse(std::span<const uint8_t> image, RomInfo &info);
+
+    // The PRG-ROM and CHR-ROM of the image, which ROM databases identify
+    // dumps by.
+    [[nodiscard]] std::span<const uint8_t> rom(std::span<const uint8_t> image) const {
+        return image.subspan(prg_rom_offset, prg_rom_size + chr_rom_size);
+    }
+};
+
+
+#endif //NES_ROM_INFO_H
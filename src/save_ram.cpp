@@ -0,0 +1,133 @@
+#include "save_ram.h"
+#include <algorithm>
+#include <bit>
+#include <condition_variable>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "log.h"
+
+namespace {
+    // The background thread that flushes every open save.
+    class Flusher {
+    public:
+        static Flusher &get() {
+            static Flusher flusher;
+            return flusher;
+        }
+
+        void add(SaveRam *save) {
+            std::lock_guard<std::mutex> lock(mutex);
+            saves.push_back(save);
+            if (!thread.joinable()) {
+                thread = std::thread(&Flusher::run, this);
+            }
+        }
+
+        // After this returns the thread won't touch the save again.
+        void remove(SaveRam *save) {
+            std::lock_guard<std::mutex> lock(mutex);
+            saves.erase(std::remove(saves.begin(), saves.end(), save), saves.end());
+        }
+
+        void set_interval(std::chrono::milliseconds new_interval) {
+            std::lock_guard<std::mutex> lock(mutex);
+            interval = new_interval;
+            wake.notify_one();
+        }
+
+        ~Flusher() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+                wake.notify_one();
+            }
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    private:
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::vector<SaveRam *> saves;
+        std::chrono::milliseconds interval{1000};
+        bool stopping = false;
+        std::thread thread;
+
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                // Flushing a save that hasn't been written to costs nothing.
+                for (SaveRam *save: saves) {
+                    save->flush();
+                }
+                if (stopping) {
+                    return;
+                }
+                wake.wait_for(lock, interval);
+            }
+        }
+    };
+}
+
+std::unique_ptr<SaveRam> SaveRam::open(const std::string &path, size_t size) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Could not open save file at path " << path)
+        return nullptr;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) < 0 || (static_cast<size_t>(info.st_size) < size && ftruncate(fd, size) < 0)) {
+        LOG_ERROR("Could not size save file at path " << path)
+        close(fd);
+        return nullptr;
+    }
+
+    // The mapping stays valid after the file is closed.
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR("Could not map save file at path " << path)
+        return nullptr;
+    }
+
+    std::unique_ptr<SaveRam> save(new SaveRam());
+    save->memory = {static_cast<uint8_t *>(mapping), size};
+    save->page_shift = std::countr_zero(static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+    if ((size - 1) >> save->page_shift >= 64) {
+        LOG_ERROR("Save RAM of " << size << " bytes is too big to track")
+        munmap(mapping, size);
+        return nullptr;
+    }
+    Flusher::get().add(save.get());
+    return save;
+}
+
+void SaveRam::set_flush_interval(std::chrono::milliseconds interval) {
+    Flusher::get().set_interval(interval);
+}
+
+SaveRam::~SaveRam() {
+    Flusher::get().remove(this);
+    flush();
+    munmap(memory.data(), memory.size());
+}
+
+void SaveRam::flush() {
+    // Sync each run of dirty pages with one call.
+    uint64_t pages = dirty.exchange(0, std::memory_order_acq_rel);
+    while (pages) {
+        int first = std::countr_zero(pages);
+        int count = std::countr_one(pages >> first);
+        size_t start = size_t(first) << page_shift;
+        size_t length = std::min(size_t(count) << page_shift, memory.size() - start);
+        if (msync(memory.data() + start, length, MS_SYNC) < 0) {
+            LOG_ERROR("Could not flush save RAM")
+        }
+        pages &= count == 64 ? 0 : ~(((uint64_t(1) << count) - 1) << first);
+    }
+}
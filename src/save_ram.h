@@ -0,0 +1,59 @@
+#ifndef NES_SAVE_RAM_H
+#define NES_SAVE_RAM_H
+
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+// Battery-backed PRG-RAM, kept in a save file that's mapped into memory.
+//
+// Writes go straight into the mapping, so they're in the OS page cache
+// (and survive the emulator crashing) as soon as they're made. Getting them
+// onto disk is left to a single background thread shared by every save,
+// which syncs the pages written since the last flush every flush interval.
+// The emulation thread never does any I/O for saving.
+class SaveRam {
+public:
+    // Map the save file at the path as the given number of bytes of RAM,
+    // creating it (or extending it with zeroes) if needed. Returns nullptr
+    // if it can't be.
+    static std::unique_ptr<SaveRam> open(const std::string &path, size_t size);
+
+    // How often the background thread flushes saves (1 second by default).
+    // A crash of the machine loses at most this much.
+    static void set_flush_interval(std::chrono::milliseconds interval);
+
+    SaveRam(const SaveRam &) = delete;
+    SaveRam &operator=(const SaveRam &) = delete;
+    // Flushes anything still dirty.
+    ~SaveRam();
+
+    [[nodiscard]] std::span<uint8_t> bytes() const { return memory; }
+
+    void write(uint32_t offset, uint8_t data) {
+        memory[offset] = data;
+        // Only the first write to a page since the last flush has to touch
+        // the shared mask.
+        uint64_t page = uint64_t(1) << (offset >> page_shift);
+        if (!(dirty.load(std::memory_order_relaxed) & page)) {
+            dirty.fetch_or(page, std::memory_order_release);
+        }
+    }
+
+    // Write the pages written since the last flush back to the file now.
+    void flush();
+    [[nodiscard]] bool is_dirty() const { return dirty.load(std::memory_order_acquire) != 0; }
+private:
+    SaveRam() = default;
+
+    std::span<uint8_t> memory;
+    uint8_t page_shift = 12;        // log2 of the OS page size
+    std::atomic<uint64_t> dirty{0}; // a bit for each OS page written to
+};
+
+
+#endif //NES_SAVE_RAM_H
@@ -0,0 +1,30 @@
+#include "scheduler.h"
+#include <algorithm>
+
+const uint64_t NOT_SCHEDULED = UINT64_MAX;
+
+Scheduler::Scheduler() {
+    times.fill(NOT_SCHEDULED);
+}
+
+void Scheduler::schedule(Event event, uint64_t time) {
+    times[static_cast<size_t>(event)] = time;
+}
+
+void Scheduler::cancel(Event event) {
+    times[static_cast<size_t>(event)] = NOT_SCHEDULED;
+}
+
+uint64_t Scheduler::time(Event event) const {
+    return times[static_cast<size_t>(event)];
+}
+
+uint64_t Scheduler::next() const {
+    // There are only a handful of events, so a linear scan beats keeping
+    // them in a priority queue.
+    return *std::min_element(times.begin(), times.end());
+}
+
+bool Scheduler::is_due(Event event, uint64_t now) const {
+    return time(event) <= now;
+}
@@ -0,0 +1,43 @@
+#ifndef NES_SCHEDULER_H
+#define NES_SCHEDULER_H
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Everything is timed against the master clock, which the CPU and PPU each
+// divide down by an amount that depends on the region (see region.h).
+//
+// Keeps the master clock time of the next event for each component that
+// runs lazily. Rather than clocking the PPU in lockstep with the CPU, the
+// bus lets the CPU run freely up to the earliest scheduled event and only
+// catches the other components up when that event comes due (or when the
+// CPU touches one of their registers).
+class Scheduler {
+public:
+    enum class Event : uint8_t {
+        Ppu,      // the PPU changes state the CPU can see (vblank, NMI)
+        FrameEnd, // the PPU finishes the current frame
+        Mapper,   // the cartridge's mapper raises an IRQ
+        Count,
+    };
+
+    Scheduler();
+
+    void schedule(Event event, uint64_t time);
+    void cancel(Event event);
+
+    // The time the event is scheduled for, or UINT64_MAX if it isn't.
+    [[nodiscard]] uint64_t time(Event event) const;
+
+    // The time of the earliest scheduled event.
+    [[nodiscard]] uint64_t next() const;
+
+    [[nodiscard]] bool is_due(Event event, uint64_t now) const;
+private:
+    std::array<uint64_t, static_cast<size_t>(Event::Count)> times;
+};
+
+
+#endif //NES_SCHEDULER_H
@@ -0,0 +1,57 @@
+#include "tile_cache.h"
+#include <algorithm>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+TileCache::TileCache(const uint8_t *chr, size_t size) : chr(chr), pixels(size * 4), dirty(size / 16, true) {
+}
+
+std::shared_ptr<TileCache> TileCache::shared(std::shared_ptr<const RomImage> image,
+                                             std::span<const uint8_t> chr_rom) {
+    // Caches are looked up by a hash of the CHR-ROM, and only kept alive by
+    // the cartridges using them.
+    static std::mutex mutex;
+    static std::unordered_multimap<size_t, std::weak_ptr<TileCache>> registry;
+
+    std::string_view contents(reinterpret_cast<const char *>(chr_rom.data()), chr_rom.size());
+    size_t hash = std::hash<std::string_view>{}(contents);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [first, last] = registry.equal_range(hash);
+    for (auto it = first; it != last;) {
+        std::shared_ptr<TileCache> cache = it->second.lock();
+        if (!cache) {
+            it = registry.erase(it);
+        } else if (std::ranges::equal(cache->rom, chr_rom)) {
+            return cache;
+        } else {
+            ++it;
+        }
+    }
+
+    auto cache = std::make_shared<TileCache>(nullptr, chr_rom.size());
+    cache->image = std::move(image);
+    cache->rom = chr_rom;
+    cache->chr = chr_rom.data();
+    // Decode everything now, since lazily decoding would mean writing to
+    // the cache from every thread sharing it.
+    for (uint32_t tile = 0; tile < cache->dirty.size(); tile++) {
+        cache->decode(tile);
+    }
+    registry.emplace(hash, cache);
+    return cache;
+}
+
+void TileCache::decode(uint32_t tile) {
+    const uint8_t *planes = &chr[tile * 16];
+    uint8_t *out = &pixels[tile * 64];
+    for (int row = 0; row < 8; row++) {
+        uint8_t low = planes[row];
+        uint8_t high = planes[row + 8];
+        for (int i = 0; i < 8; i++) {
+            *out++ = ((low >> (7 - i)) & 0x01) | (((high >> (7 - i)) & 0x01) << 1);
+        }
+    }
+    dirty[tile] = false;
+}
@@ -0,0 +1,54 @@
+#ifndef NES_TILE_CACHE_H
+#define NES_TILE_CACHE_H
+
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include "rom_image.h"
+
+// CHR tiles decoded ahead of time. In CHR memory each 8x8 tile is stored as
+// two bitplanes of 8 bytes; here each row is kept as 8 bytes holding the
+// 2-bit color of each pixel, so the PPU can copy pixels straight out of it.
+//
+// The cache is indexed by offset into the cartridge's CHR memory rather
+// than by PPU address, so switching CHR banks just means reading different
+// tiles out of it, and nothing has to be thrown away.
+class TileCache {
+public:
+    // A cache for CHR-RAM, decoded lazily from the given memory as tiles
+    // are used, and again after they're written to.
+    TileCache(const uint8_t *chr, size_t size);
+
+    // The cache for the CHR-ROM in a ROM image. CHR-ROM never changes, so
+    // the cache is decoded up front and shared by every cartridge with the
+    // same CHR-ROM. It reads the CHR-ROM out of the image, and keeps it alive.
+    static std::shared_ptr<TileCache> shared(std::shared_ptr<const RomImage> image,
+                                             std::span<const uint8_t> chr_rom);
+
+    // The 8 decoded pixels of the tile row at the offset into CHR memory.
+    const uint8_t *row(uint32_t offset) {
+        uint32_t tile = offset >> 4;
+        if (dirty[tile]) {
+            decode(tile);
+        }
+        return &pixels[(tile << 6) | ((offset & 0x07) << 3)];
+    }
+
+    // Note that the byte at the offset into CHR memory was written to.
+    void invalidate(uint32_t offset) {
+        dirty[offset >> 4] = true;
+    }
+private:
+    const uint8_t *chr;
+    std::shared_ptr<const RomImage> image; // holding the CHR-ROM, for shared caches
+    std::span<const uint8_t> rom;
+    std::vector<uint8_t> pixels; // 64 per tile
+    std::vector<bool> dirty;     // tiles that need decoding
+
+    void decode(uint32_t tile);
+};
+
+
+#endif //NES_TILE_CACHE_H
@@ -1,10 +1,14 @@
 #ifndef NES_UTILS_H
 #define NES_UTILS_H
 
+#include <bit>
 #include <cstdint>
 
 namespace utils {
-    uint8_t count_trailing_zeroes(uint16_t flag);
+    // Count the number of trailing zero bits, or 0 if no bits are set.
+    constexpr uint8_t count_trailing_zeroes(uint16_t bits) {
+        return bits == 0 ? 0 : std::countr_zero(bits);
+    }
 }
 
 #endif //NES_UTILS_H
@@ -0,0 +1,27 @@
+#include <gtest/gtest.h>
+#include "../src/bus.h"
+
+TEST(BusTest, test_ram_is_mirrored) {
+    Bus bus;
+    bus.write(0x0012, 0x34);
+    EXPECT_EQ(bus.read(0x0012), 0x34);
+    EXPECT_EQ(bus.read(0x0812), 0x34);
+    EXPECT_EQ(bus.read(0x1012), 0x34);
+    EXPECT_EQ(bus.read(0x1812), 0x34);
+
+    bus.write(0x1FFF, 0x56);
+    EXPECT_EQ(bus.read(0x07FF), 0x56);
+}
+
+TEST(BusTest, test_map_page) {
+    Bus bus;
+    uint8_t bank[256] = {};
+    bank[0x10] = 0xAB;
+
+    bus.map_page(0x60, bank, nullptr);
+    EXPECT_EQ(bus.read(0x6010), 0xAB);
+
+    bus.map_page(0x60, bank, bank);
+    bus.write(0x60FF, 0xCD);
+    EXPECT_EQ(bank[0xFF], 0xCD);
+}
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include "../src/cartridge.h"
+
+// Write an image with the given header bytes 4-15, with each byte of PRG-ROM
+// set to its 8KB bank number and each byte of CHR-ROM to its 1KB bank
+// number, and return its path.
+static std::string write_rom(std::initializer_list<char> header_bytes) {
+    std::string path = testing::TempDir() + "cartridge_test.nes";
+    std::ofstream file(path, std::ios::binary);
+    char header[16] = {'N', 'E', 'S', '\x1A', 1, 0};
+    std::copy(header_bytes.begin(), header_bytes.end(), header + 4);
+    file.write(header, sizeof(header));
+    for (int bank = 0; bank < header[4] * 2; bank++) {
+        file.write(std::string(0x2000, static_cast<char>(bank)).data(), 0x2000);
+    }
+    for (int bank = 0; bank < header[5] * 8; bank++) {
+        file.write(std::string(0x400, static_cast<char>(bank)).data(), 0x400);
+    }
+    return path;
+}
+
+TEST(CartridgeTest, test_region_is_read_from_header) {
+    auto region = [](std::initializer_list<char> header_bytes) {
+        Cartridge cartridge;
+        EXPECT_TRUE(cartridge.load(write_rom(header_bytes)));
+        return cartridge.get_region();
+    };
+    EXPECT_EQ(region({1, 0}), Region::NTSC);
+    EXPECT_EQ(region({1, 0, 0, 0, 0, 1}), Region::PAL); // iNES flags 9
+
+    // NES 2.0 puts it in byte 12.
+    EXPECT_EQ(region({1, 0, 0, 0x08, 0, 0, 0, 0, 1}), Region::PAL);
+    EXPECT_EQ(region({1, 0, 0, 0x08, 0, 0, 0, 0, 2}), Region::NTSC);
+    EXPECT_EQ(region({1, 0, 0, 0x08, 0, 0, 0, 0, 3}), Region::Dendy);
+}
+
+TEST(CartridgeTest, test_nrom_banks) {
+    Cartridge cartridge;
+    ASSERT_TRUE(cartridge.load(write_rom({1, 1})));
+    // 16KB of PRG-ROM is mirrored into $C000-$FFFF.
+    EXPECT_EQ(cartridge.prg_read(0x8000), 0);
+    EXPECT_EQ(cartridge.prg_read(0xA000), 1);
+    EXPECT_EQ(cartridge.prg_read(0xC000), 0);
+    EXPECT_EQ(cartridge.prg_page(0xE100), cartridge.prg_page(0xA100));
+    EXPECT_EQ(cartridge.chr_read(0x1C00), 7);
+
+    // There are no registers, and ROM can't be written.
+    EXPECT_FALSE(cartridge.prg_write(0x8000, 0x55));
+    EXPECT_EQ(cartridge.prg_read(0x8000), 0);
+
+    ASSERT_TRUE(cartridge.load(write_rom({2, 1})));
+    EXPECT_EQ(cartridge.prg_read(0xE000), 3);
+}
+
+TEST(CartridgeTest, test_mmc1_banks) {
+    Cartridge cartridge;
+    ASSERT_TRUE(cartridge.load(write_rom({8, 2, 0x10})));
+    // Registers are written a bit at a time, low bit first.
+    auto write_register = [&cartridge](uint16_t address, uint8_t data) {
+        for (int bit = 0; bit < 4; bit++) {
+            EXPECT_FALSE(cartridge.prg_write(address, data >> bit));
+        }
+        EXPECT_TRUE(cartridge.prg_write(address, data >> 4));
+    };
+
+    // At power on the last 16KB bank is fixed at $C000.
+    EXPECT_EQ(cartridge.prg_read(0x8000), 0);
+    EXPECT_EQ(cartridge.prg_read(0xE000), 15);
+    write_register(0xE000, 3);
+    EXPECT_EQ(cartridge.prg_read(0x8000), 6);
+    EXPECT_EQ(cartridge.prg_read(0xA000), 7);
+    EXPECT_EQ(cartridge.prg_read(0xC000), 14);
+
+    // Fix the first bank at $8000 and switch $C000, with vertical mirroring
+    // and 4KB CHR banks.
+    write_register(0x8000, 0x1A);
+    EXPECT_EQ(cartridge.get_mirror(), Mapper::Vertical);
+    EXPECT_EQ(cartridge.prg_read(0x8000), 0);
+    EXPECT_EQ(cartridge.prg_read(0xC000), 6);
+    write_register(0xA000, 1);
+    write_register(0xC000, 2);
+    EXPECT_EQ(cartridge.chr_read(0x0000), 4);
+    EXPECT_EQ(cartridge.chr_read(0x1C00), 11);
+
+    // 32KB mode ignores the low bit of the bank.
+    write_register(0x8000, 0x03);
+    EXPECT_EQ(cartridge.get_mirror(), Mapper::Horizontal);
+    EXPECT_EQ(cartridge.prg_read(0x8000), 4);
+    EXPECT_EQ(cartridge.prg_read(0xE000), 7);
+    EXPECT_EQ(cartridge.chr_read(0x1C00), 7);
+
+    // Bit 7 resets the shift register part way through.
+    cartridge.prg_write(0xE000, 1);
+    EXPECT_TRUE(cartridge.prg_write(0xE000, 0x80));
+    EXPECT_EQ(cartridge.prg_read(0xE000), 15);
+}
+
+TEST(CartridgeTest, test_uxrom_and_cnrom_banks) {
+    Cartridge cartridge;
+    ASSERT_TRUE(cartridge.load(write_rom({4, 0, 0x20})));
+    EXPECT_TRUE(cartridge.prg_write(0x8000, 2));
+    EXPECT_EQ(cartridge.prg_read(0x8000), 4);
+    EXPECT_EQ(cartridge.prg_read(0xA000), 5);
+    EXPECT_EQ(cartridge.prg_read(0xC000), 6);
+    EXPECT_EQ(cartridge.prg_read(0xE000), 7);
+
+    ASSERT_TRUE(cartridge.load(write_rom({1, 4, 0x30})));
+    EXPECT_TRUE(cartridge.prg_write(0xFFFF, 3));
+    EXPECT_EQ(cartridge.chr_read(0x0000), 24);
+    EXPECT_EQ(cartridge.chr_read(0x1C00), 31);
+    EXPECT_EQ(cartridge.prg_read(0xC000), 0);
+}
+
+TEST(CartridgeTest, test_mmc3_banks) {
+    Cartridge cartridge;
+    ASSERT_TRUE(cartridge.load(write_rom({4, 2, 0x40})));
+    auto select = [&cartridge](uint8_t bank_select, uint8_t bank) {
+        cartridge.prg_write(0x8000, bank_select);
+        EXPECT_TRUE(cartridge.prg_write(0x8001, bank));
+    };
+
+    select(6, 3);
+    select(7, 4);
+    EXPECT_EQ(cartridge.prg_read(0x8000), 3);
+    EXPECT_EQ(cartridge.prg_read(0xA000), 4);
+    EXPECT_EQ(cartridge.prg_read(0xC000), 6);
+    EXPECT_EQ(cartridge.prg_read(0xE000), 7);
+
+    // PRG mode 1 swaps $8000 and $C000.
+    select(0x46, 3);
+    EXPECT_EQ(cartridge.prg_read(0x8000), 6);
+    EXPECT_EQ(cartridge.prg_read(0xC000), 3);
+
+    // Two 2KB banks then four 1KB banks, or the other way around when CHR
+    // is inverted.
+    select(0, 5);
+    select(5, 9);
+    EXPECT_EQ(cartridge.chr_read(0x0000), 4);
+    EXPECT_EQ(cartridge.chr_read(0x0400), 5);
+    EXPECT_EQ(cartridge.chr_read(0x1C00), 9);
+    select(0x80, 5);
+    EXPECT_EQ(cartridge.chr_read(0x1000), 4);
+    EXPECT_EQ(cartridge.chr_read(0x0C00), 9);
+
+    EXPECT_TRUE(cartridge.prg_write(0xA000, 1));
+    EXPECT_EQ(cartridge.get_mirror(), Mapper::Horizontal);
+}
+
+TEST(CartridgeTest, test_identical_roms_share_one_image) {
+    std::string path = write_rom({2, 1});
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> bytes(std::istreambuf_iterator<char>(file), {});
+
+    Cartridge mapped, copied, copied_again;
+    ASSERT_TRUE(mapped.load(path));
+    ASSERT_TRUE(copied.load_from_memory(bytes));
+    ASSERT_TRUE(copied_again.load_from_memory(bytes));
+    EXPECT_EQ(copied.prg_read(0xE000), 3);
+    EXPECT_EQ(copied.chr_read(0x0400), 1);
+
+    // All three read ROM out of the same memory, which isn't the caller's.
+    EXPECT_EQ(copied.prg_page(0x8000), mapped.prg_page(0x8000));
+    EXPECT_EQ(copied_again.prg_page(0x8000), mapped.prg_page(0x8000));
+    EXPECT_NE(copied.prg_page(0x8000), &bytes[16]);
+}
+
+TEST(CartridgeTest, test_truncated_rom_is_rejected) {
+    std::string path = write_rom({2, 1});
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> bytes(std::istreambuf_iterator<char>(file), {});
+    bytes.pop_back();
+
+    Cartridge cartridge;
+    EXPECT_FALSE(cartridge.load_from_memory(bytes));
+    EXPECT_FALSE(cartridge.load_from_memory(std::span(bytes).first(8)));
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "../src/compositor.h"
+
+using namespace compositor;
+
+TEST(CompositorTest, test_sprite_priority) {
+    uint8_t background[LINE_WIDTH] = {};
+    uint8_t sprites[LINE_WIDTH] = {};
+    uint8_t out[LINE_WIDTH];
+    background[20] = 0x05;
+    sprites[20] = 0x11;
+    background[21] = 0x05;
+    sprites[21] = 0x11 | SpriteBehind;
+    background[22] = 0x00;
+    sprites[22] = 0x11 | SpriteBehind;
+    PpuMask mask;
+    mask.set_value(0x1E);
+
+    EXPECT_EQ(compose(background, sprites, out, 0, mask), -1);
+    EXPECT_EQ(out[20], 0x11);
+    EXPECT_EQ(out[21], 0x05);
+    EXPECT_EQ(out[22], 0x11);
+}
+
+TEST(CompositorTest, test_sprite_zero_hit_skips_clipped_column_and_last_pixel) {
+    uint8_t background[LINE_WIDTH];
+    uint8_t sprites[LINE_WIDTH] = {};
+    uint8_t out[LINE_WIDTH];
+    std::fill_n(background, LINE_WIDTH, 0x01);
+    sprites[3] = 0x11 | SpriteZero;
+    sprites[255] = 0x11 | SpriteZero;
+    PpuMask mask;
+
+    mask.set_value(PpuMask::ShowBackground | PpuMask::ShowSprites);
+    EXPECT_EQ(compose(background, sprites, out, 0, mask), -1);
+    EXPECT_EQ(out[3], 0x00);
+
+    mask.set(PpuMask::ShowLeftBackground | PpuMask::ShowLeftSprites);
+    EXPECT_EQ(compose(background, sprites, out, 0, mask), 3);
+    EXPECT_EQ(compose(background, sprites, out, 4, mask), -1);
+}
+
+TEST(CompositorTest, test_matches_scalar_version) {
+    std::mt19937 random(1234);
+    uint8_t background[LINE_WIDTH];
+    uint8_t sprites[LINE_WIDTH];
+    uint8_t out[LINE_WIDTH];
+    uint8_t expected[LINE_WIDTH];
+
+    for (int line = 0; line < 200; line++) {
+        for (int x = 0; x < LINE_WIDTH; x++) {
+            uint8_t pixel = random() & 0x03;
+            background[x] = pixel ? ((random() & 0x0C) | pixel) : 0;
+            pixel = random() % 8 < 6 ? 0 : random() & 0x03;
+            sprites[x] = pixel ? (0x10 | (random() & 0x0C) | pixel | (random() & (SpriteBehind | SpriteZero))) : 0;
+        }
+        PpuMask mask;
+        mask.set_value(random() & 0x1E);
+        int first_x = line % 3 == 0 ? 0 : random() % LINE_WIDTH;
+
+        std::fill_n(out, LINE_WIDTH, 0xFF);
+        std::fill_n(expected, LINE_WIDTH, 0xFF);
+        ASSERT_EQ(compose(background, sprites, out, first_x, mask),
+                  compose_scalar(background, sprites, expected, first_x, mask)) << "line " << line;
+        ASSERT_EQ(0, memcmp(out, expected, LINE_WIDTH)) << "line " << line;
+    }
+}
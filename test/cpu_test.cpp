@@ -1,5 +1,6 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <fstream>
 #include "../src/bus.h"
 
 class MockBus : public Bus {
@@ -8,6 +9,9 @@ class MockBus : public Bus {
 class TestCpu : public Cpu {
 public:
     TestCpu(Bus *bus) : Cpu(bus) {
+        // Reads are mocked rather than coming from memory, so the CPU
+        // can't decode blocks of code straight from memory.
+        cache_blocks = false;
     }
 
     MOCK_METHOD(uint8_t, read, (uint16_t address), (override));
@@ -107,3 +111,276 @@ TEST_F(CpuTests, test_lda_with_absolute_addressing) {
     EXPECT_EQ(cpu->get_cycles(), 3);
     EXPECT_EQ(cpu->get_total_cycles(), 1);
 }
+
+TEST_F(CpuTests, test_run_until_executes_whole_instructions) {
+    // Two NOPs, each of which takes 2 cycles.
+    expect_read(0x0001, 0xEA);
+    expect_read(0x0002, 0xEA);
+
+    // The second NOP runs past the target by a single cycle.
+    EXPECT_EQ(cpu->run_until(3), 1);
+    EXPECT_EQ(cpu->get_pc(), 0x0003);
+    EXPECT_EQ(cpu->get_cycles(), 0);
+    EXPECT_EQ(cpu->get_total_cycles(), 4);
+}
+
+TEST_F(CpuTests, test_lda_with_zero_page_addressing) {
+    // LDA $10
+    expect_read(0x0001, 0xA5);
+    expect_read(0x0002, 0x10);
+    expect_read(0x0010, 0x80);
+
+    cpu->cycle();
+
+    EXPECT_EQ(cpu->get_current_instruction().type, Cpu::InstructionType::LDA);
+    EXPECT_EQ(cpu->get_current_address(), 0x0010);
+    EXPECT_EQ(cpu->get_a(), 0x80);
+    EXPECT_EQ(cpu->get_pc(), 0x0003);
+    EXPECT_EQ(cpu->get_cycles(), 2);
+}
+
+// A CPU that runs real code out of the bus' memory, rather than mocked reads.
+class MemoryCpu : public Cpu {
+public:
+    explicit MemoryCpu(Bus *bus, bool cache_blocks = true) : Cpu(bus) {
+        this->cache_blocks = cache_blocks;
+    }
+
+    uint8_t get_a() {
+        return a;
+    }
+
+    uint8_t get_x() {
+        return x;
+    }
+
+    uint16_t get_pc() {
+        return pc;
+    }
+};
+
+// Load a program into RAM at $0200 and point the reset vector at it.
+static void load_program(Bus &bus, uint8_t *vectors, const std::vector<uint8_t> &program) {
+    vectors[0xFC] = 0x00;
+    vectors[0xFD] = 0x02;
+    bus.map_page(0xFF, vectors, nullptr);
+    for (uint16_t i = 0; i < program.size(); i++) {
+        bus.write(0x0200 + i, program[i]);
+    }
+}
+
+TEST(CpuBlockCacheTest, test_self_modifying_code_in_ram) {
+    Bus bus;
+    MemoryCpu cpu(&bus);
+    bus.connect_cpu(&cpu);
+
+    // Each time around the loop, X is loaded from the LDX operand, then
+    // incremented and written back over that operand.
+    uint8_t vectors[256] = {};
+    load_program(bus, vectors, {
+        0xA2, 0x00,       // LDX #$00
+        0xE8,             // INX
+        0x8E, 0x01, 0x02, // STX $0201
+        0x4C, 0x00, 0x02, // JMP $0200
+    });
+    cpu.initialize();
+
+    // Each time around the loop takes 11 cycles.
+    EXPECT_EQ(cpu.run_until(11 * 10), 0);
+    EXPECT_EQ(cpu.get_x(), 10);
+    EXPECT_EQ(bus.read(0x0201), 10);
+}
+
+TEST(CpuBlockCacheTest, test_idle_loop_is_skipped_exactly) {
+    // Wait for a flag in RAM that never gets set.
+    const std::vector<uint8_t> program = {
+        0xA9, 0x01,       // LDA #$01
+        0xA5, 0x10,       // LDA $10
+        0xF0, 0xFC,       // BEQ $0202
+    };
+
+    Bus cached_bus;
+    MemoryCpu cached(&cached_bus);
+    uint8_t cached_vectors[256] = {};
+    load_program(cached_bus, cached_vectors, program);
+    cached.initialize();
+
+    Bus uncached_bus;
+    MemoryCpu uncached(&uncached_bus, false);
+    uint8_t uncached_vectors[256] = {};
+    load_program(uncached_bus, uncached_vectors, program);
+    uncached.initialize();
+
+    for (uint64_t target: {100, 1001, 5000}) {
+        EXPECT_EQ(cached.run_until(target), uncached.run_until(target));
+        EXPECT_EQ(cached.get_total_cycles(), uncached.get_total_cycles());
+        EXPECT_EQ(cached.get_pc(), uncached.get_pc());
+        EXPECT_EQ(cached.get_a(), uncached.get_a());
+    }
+
+    // Far too many cycles to actually run.
+    uint64_t target = 1000000000000;
+    uint64_t overshoot = cached.run_until(target);
+    EXPECT_EQ(cached.get_total_cycles(), target + overshoot);
+    EXPECT_EQ(cached.get_a(), 0);
+}
+
+TEST(CpuInterruptTest, test_vblank_nmi_is_taken_every_frame) {
+    Bus bus;
+    Ppu ppu;
+    MemoryCpu cpu(&bus);
+    bus.connect_cpu(&cpu);
+    bus.connect_ppu(&ppu);
+
+    // Turn on NMIs and wait for a flag that never gets set, while the NMI
+    // handler at $0300 counts frames in X.
+    uint8_t vectors[256] = {};
+    vectors[0xFA] = 0x00;
+    vectors[0xFB] = 0x03;
+    load_program(bus, vectors, {
+        0xA9, 0x80,       // LDA #$80
+        0x8D, 0x00, 0x20, // STA $2000
+        0xA5, 0x10,       // LDA $10
+        0xF0, 0xFC,       // BEQ $0205
+    });
+    bus.write(0x0300, 0xE8); // INX
+    bus.write(0x0301, 0x40); // RTI
+    cpu.initialize();
+
+    for (int frame = 1; frame <= 3; frame++) {
+        bus.run_frame();
+        EXPECT_EQ(cpu.get_x(), frame);
+        EXPECT_EQ(ppu.get_frame(), frame);
+    }
+}
+
+TEST(CpuDmaTest, test_oam_dma_copies_page_and_stalls_cpu) {
+    // Run the DMA once starting on an even cycle and once on an odd one.
+    for (bool delay: {false, true}) {
+        Bus bus;
+        Ppu ppu;
+        MemoryCpu cpu(&bus);
+        bus.connect_cpu(&cpu);
+        bus.connect_ppu(&ppu);
+
+        uint8_t vectors[256] = {};
+        std::vector<uint8_t> program = {
+            0xA9, 0x03,       // LDA #$03
+            0x8D, 0x14, 0x40, // STA $4014
+        };
+        if (delay) {
+            program.insert(program.begin(), {0xA5, 0x00}); // LDA $00
+        }
+        load_program(bus, vectors, program);
+        for (uint16_t i = 0; i < 256; i++) {
+            bus.write(0x0300 + i, i);
+        }
+        cpu.initialize();
+
+        // One instruction at a time, up to the STA.
+        cpu.run_until(cpu.get_total_cycles() + 1);
+        if (delay) {
+            cpu.run_until(cpu.get_total_cycles() + 1);
+        }
+        uint64_t start = cpu.get_total_cycles();
+        cpu.run_until(start + 1);
+
+        // The DMA takes 513 cycles, or 514 to line up its reads, and so
+        // always finishes on the same parity.
+        uint64_t taken = cpu.get_total_cycles() - start;
+        EXPECT_EQ(taken, 4 + 513 + ((start + 4) & 1));
+        EXPECT_EQ(cpu.get_total_cycles() & 1, 1);
+
+        bus.write(0x2003, 0x04);
+        EXPECT_EQ(bus.read(0x2004), 0x04);
+        bus.write(0x2003, 0x06);
+        EXPECT_EQ(bus.read(0x2004), 0x06 & 0xE3);
+    }
+}
+
+TEST(CpuDmaTest, test_oam_dma_stall_is_counted_without_block_cache) {
+    // Without the block cache each instruction goes through step(), which
+    // has to return the whole stall along with the STA's own cycles.
+    Bus bus;
+    Ppu ppu;
+    MemoryCpu cpu(&bus, false);
+    bus.connect_cpu(&cpu);
+    bus.connect_ppu(&ppu);
+
+    uint8_t vectors[256] = {};
+    load_program(bus, vectors, {
+        0xA9, 0x03,       // LDA #$03
+        0x8D, 0x14, 0x40, // STA $4014
+        0xA9, 0x42,       // LDA #$42
+    });
+    bus.write(0x0307, 0x99);
+    cpu.initialize();
+
+    cpu.run_until(cpu.get_total_cycles() + 1);
+    uint64_t start = cpu.get_total_cycles();
+    cpu.run_until(start + 1);
+
+    EXPECT_EQ(cpu.get_total_cycles() - start, 4 + 513 + ((start + 4) & 1));
+    EXPECT_EQ(cpu.get_pc(), 0x0205);
+
+    bus.write(0x2003, 0x07);
+    EXPECT_EQ(bus.read(0x2004), 0x99);
+}
+
+TEST(CpuInterruptTest, test_mmc3_irq_is_taken_on_its_scanline) {
+    // An MMC3 cartridge (the contents of ROM don't matter).
+    std::string path = testing::TempDir() + "cpu_mmc3_test.nes";
+    std::ofstream(path, std::ios::binary)
+            .write("NES\x1A\x02\x01\x40\0\0\0\0\0\0\0\0\0", 16)
+            .write(std::string(0xA000, '\0').data(), 0xA000);
+    Cartridge cartridge;
+    ASSERT_TRUE(cartridge.load(path));
+
+    Bus bus;
+    Ppu ppu;
+    MemoryCpu cpu(&bus);
+    bus.connect_cpu(&cpu);
+    bus.connect_ppu(&ppu);
+    bus.load_cartridge(&cartridge);
+
+    // Turn on rendering with sprites at $1000 so A12 rises once a line, and
+    // have the mapper count 10 lines between IRQs. The IRQ handler at $0300
+    // counts them in X.
+    uint8_t vectors[256] = {};
+    vectors[0xFE] = 0x00;
+    vectors[0xFF] = 0x03;
+    load_program(bus, vectors, {
+        0xA9, 0x08,       // LDA #$08
+        0x8D, 0x00, 0x20, // STA $2000
+        0xA9, 0x18,       // LDA #$18
+        0x8D, 0x01, 0x20, // STA $2001
+        0xA9, 0x0A,       // LDA #$0A
+        0x8D, 0x00, 0xC0, // STA $C000
+        0x8D, 0x01, 0xC0, // STA $C001
+        0x8D, 0x01, 0xE0, // STA $E001
+        0x58,             // CLI
+        0x4C, 0x16, 0x02, // JMP $0216
+    });
+    const uint8_t handler[] = {
+        0xE8,             // INX
+        0x8D, 0x00, 0xE0, // STA $E000
+        0x8D, 0x01, 0xE0, // STA $E001
+        0x40,             // RTI
+    };
+    for (uint16_t i = 0; i < sizeof(handler); i++) {
+        bus.write(0x0300 + i, handler[i]);
+    }
+    cpu.initialize();
+
+    // The counter is loaded on line 0 and reaches 0 on line 10, at dot 260.
+    while (cpu.get_x() == 0 && cpu.get_total_cycles() < 10000) {
+        bus.run_until(cpu.get_total_cycles() + 1);
+    }
+    uint64_t raised = (10 * 341 + 261 + 2) / 3;
+    EXPECT_GE(cpu.get_total_cycles(), raised + 7 + 2);
+    EXPECT_LE(cpu.get_total_cycles(), raised + 3 + 7 + 2);
+
+    // After that it goes off every 11 lines, up to line 230.
+    bus.run_frame();
+    EXPECT_EQ(cpu.get_x(), 21);
+}
@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "../src/hash.h"
+
+static std::span<const uint8_t> bytes(const std::string &text) {
+    return {reinterpret_cast<const uint8_t *>(text.data()), text.size()};
+}
+
+TEST(HashTest, test_crc32) {
+    EXPECT_EQ(hash::crc32(bytes("")), 0u);
+    EXPECT_EQ(hash::crc32(bytes("123456789")), 0xCBF43926u);
+
+    // Lengths that aren't a multiple of 8, and continuing from a result.
+    std::string text = "The quick brown fox jumps over the lazy dog";
+    EXPECT_EQ(hash::crc32(bytes(text)), 0x414FA339u);
+    EXPECT_EQ(hash::crc32(bytes(text.substr(13)), hash::crc32(bytes(text.substr(0, 13)))), 0x414FA339u);
+}
+
+TEST(HashTest, test_sha1) {
+    auto hex = [](const std::array<uint8_t, 20> &digest) {
+        std::string text;
+        for (uint8_t byte: digest) {
+            text += "0123456789abcdef"[byte >> 4];
+            text += "0123456789abcdef"[byte & 0x0F];
+        }
+        return text;
+    };
+    EXPECT_EQ(hex(hash::sha1(bytes(""))), "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+    EXPECT_EQ(hex(hash::sha1(bytes("abc"))), "a9993e364706816aba3e25717850c26c9cd0d89d");
+    // Padding that spills into a second block.
+    EXPECT_EQ(hex(hash::sha1(bytes("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"))),
+              "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+    std::vector<uint8_t> million(1000000, 'a');
+    EXPECT_EQ(hex(hash::sha1(million)), "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+}
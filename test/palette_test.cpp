@@ -0,0 +1,27 @@
+#include <gtest/gtest.h>
+#include "../src/palette.h"
+
+TEST(PaletteTest, test_conversions) {
+    Palette palette;
+    const uint16_t pixels[] = {0x30, 0x0F, 0x16, 0x30 | Palette::EmphasizeRed, 0x20};
+    uint32_t rgba[5];
+    uint16_t rgb565[5];
+    uint8_t gray[5];
+    palette.to_rgba32(pixels, rgba, 5);
+    palette.to_rgb565(pixels, rgb565, 5);
+    palette.to_grayscale(pixels, gray, 5);
+
+    EXPECT_EQ(rgba[0], 0xFFECEEEC);
+    EXPECT_EQ(rgba[1], 0xFF000000);
+    EXPECT_EQ(rgb565[1], 0x0000);
+    EXPECT_EQ(rgb565[4], (236 >> 3) << 11 | (238 >> 2) << 5 | (236 >> 3));
+    EXPECT_EQ(gray[1], 0);
+    EXPECT_EQ(gray[0], (236 * 299 + 238 * 587 + 236 * 114) / 1000);
+
+    // Emphasizing red dims green and blue.
+    Palette::Color emphasized = palette.color(pixels[3]);
+    EXPECT_EQ(emphasized.r, 236);
+    EXPECT_LT(emphasized.g, 238);
+    EXPECT_LT(emphasized.b, 236);
+    EXPECT_EQ(rgba[3] & 0xFF, 236);
+}
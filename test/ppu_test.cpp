@@ -0,0 +1,453 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include "../src/cartridge.h"
+#include "../src/palette.h"
+#include "../src/ppu.h"
+
+// Vblank starts on dot 1 of scanline 241.
+const uint64_t VBLANK_START = 241 * 341 + 1;
+
+TEST(PpuTest, test_vblank_starts_on_scanline_241) {
+    Ppu ppu;
+    EXPECT_EQ(ppu.next_event(), VBLANK_START + 1);
+
+    ppu.run_until(VBLANK_START);
+    EXPECT_EQ(ppu.cpu_read(0x2002) & 0x80, 0);
+
+    ppu.clock();
+    EXPECT_EQ(ppu.cpu_read(0x2002) & 0x80, 0x80);
+    // Reading PPUSTATUS clears the flag.
+    EXPECT_EQ(ppu.cpu_read(0x2002) & 0x80, 0);
+}
+
+TEST(PpuTest, test_pal_and_dendy_timing) {
+    // Both have 312 lines and no short frames, but Dendy starts vblank later.
+    for (auto [region, vblank_line]: {std::pair{Region::PAL, 241}, std::pair{Region::Dendy, 291}}) {
+        Ppu ppu;
+        ppu.set_region(region);
+        // Move every sprite off screen, so no line has too many of them.
+        for (int i = 0; i < 256; i++) {
+            ppu.cpu_write(0x2004, 0xFF);
+        }
+        ppu.cpu_write(0x2001, 0x1E);
+        uint64_t vblank = vblank_line * 341 + 1;
+        EXPECT_EQ(ppu.next_event(), vblank + 1);
+        ppu.run_until(vblank + 1);
+        EXPECT_EQ(ppu.cpu_read(0x2002) & 0x80, 0x80);
+
+        EXPECT_EQ(ppu.next_frame(), 312 * 341);
+        ppu.run_until(ppu.next_frame());
+        EXPECT_EQ(ppu.next_frame(), 2 * 312 * 341);
+    }
+}
+
+TEST(PpuTest, test_nmi_is_raised_at_vblank) {
+    Ppu ppu;
+    ppu.cpu_write(0x2000, 0x80);
+    ppu.run_until(VBLANK_START);
+    EXPECT_FALSE(ppu.poll_nmi());
+
+    ppu.run_until(VBLANK_START + 100);
+    EXPECT_TRUE(ppu.poll_nmi());
+    EXPECT_FALSE(ppu.poll_nmi());
+}
+
+TEST(PpuTest, test_enabling_nmi_during_vblank_raises_nmi) {
+    Ppu ppu;
+    ppu.run_until(VBLANK_START + 1);
+    EXPECT_FALSE(ppu.poll_nmi());
+
+    ppu.cpu_write(0x2000, 0x80);
+    EXPECT_TRUE(ppu.poll_nmi());
+}
+
+TEST(PpuTest, test_odd_frames_are_short_while_rendering) {
+    Ppu ppu;
+    EXPECT_EQ(ppu.next_frame(), 341 * 262);
+    ppu.run_until(341 * 262);
+    EXPECT_EQ(ppu.get_frame(), 1);
+
+    ppu.cpu_write(0x2001, 0x08);
+    EXPECT_EQ(ppu.next_frame(), 341 * 262 * 2 - 1);
+    ppu.run_until(341 * 262 * 2 - 1);
+    EXPECT_EQ(ppu.get_frame(), 2);
+}
+
+// Write an NROM image with 16KB of PRG-ROM and CHR-RAM, and the given
+// flags 6 (mirroring), and return its path.
+static std::string write_test_rom(const std::string &name, uint8_t flags6 = 0) {
+    std::string path = testing::TempDir() + name;
+    std::ofstream file(path, std::ios::binary);
+    const char header[16] = {'N', 'E', 'S', '\x1A', 1, 0, static_cast<char>(flags6)};
+    file.write(header, sizeof(header));
+    file.write(std::string(0x4000, '\0').data(), 0x4000);
+    return path;
+}
+
+TEST(PpuTest, test_nametable_mirroring) {
+    // Write a byte to each logical nametable, and see which ones it shows up in.
+    auto nametables_seen = [](uint8_t flags6) {
+        Cartridge cartridge;
+        EXPECT_TRUE(cartridge.load(write_test_rom("ppu_mirroring_test.nes", flags6)));
+        Ppu ppu;
+        ppu.connect_cartridge(&cartridge);
+        std::vector<int> seen;
+        for (uint16_t table = 0; table < 4; table++) {
+            ppu.ppu_write(0x2000 + table * 0x400 + 5, table + 1);
+        }
+        for (uint16_t table = 0; table < 4; table++) {
+            seen.push_back(ppu.ppu_read(0x2000 + table * 0x400 + 5));
+        }
+        // $3000-$3EFF mirrors $2000-$2EFF.
+        EXPECT_EQ(ppu.ppu_read(0x3005), seen[0]);
+        return seen;
+    };
+    EXPECT_EQ(nametables_seen(0x00), (std::vector<int>{2, 2, 4, 4})); // horizontal
+    EXPECT_EQ(nametables_seen(0x01), (std::vector<int>{3, 4, 3, 4})); // vertical
+    EXPECT_EQ(nametables_seen(0x08), (std::vector<int>{1, 2, 3, 4})); // four-screen
+}
+
+// A PPU with a CHR-RAM cartridge, so pattern tables can be written through
+// PPUDATA like everything else.
+class PpuRenderTest : public ::testing::Test {
+protected:
+    Cartridge cartridge;
+    Ppu ppu;
+
+    void SetUp() override {
+        ASSERT_TRUE(cartridge.load(write_test_rom("ppu_render_test.nes")));
+        ppu.connect_cartridge(&cartridge);
+
+        // Start in vblank, where VRAM can be written freely.
+        ppu.run_until(VBLANK_START + 1);
+    }
+
+    void write_vram(uint16_t address, const std::vector<uint8_t> &data) {
+        ppu.cpu_write(0x2006, address >> 8);
+        ppu.cpu_write(0x2006, address & 0xFF);
+        for (uint8_t byte: data) {
+            ppu.cpu_write(0x2007, byte);
+        }
+    }
+
+    // Reset the scroll and turn on rendering, then run to the end of the
+    // next frame's visible scanlines.
+    void render_frame(uint8_t scroll_x = 0, uint8_t mask = 0x1E) {
+        ppu.cpu_write(0x2000, 0x00);
+        ppu.cpu_write(0x2005, scroll_x);
+        ppu.cpu_write(0x2005, 0x00);
+        ppu.cpu_write(0x2001, mask);
+        ppu.run_until(ppu.next_frame() + 240 * 341);
+    }
+
+    [[nodiscard]] uint16_t pixel(size_t x, size_t y) const {
+        return ppu.get_framebuffer()[y * Ppu::SCREEN_WIDTH + x];
+    }
+};
+
+TEST_F(PpuRenderTest, test_background_tile_is_drawn) {
+    write_vram(0x0010, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}); // tile 1 uses color 1
+    write_vram(0x2000, {0x01});
+    write_vram(0x3F00, {0x0F, 0x30});
+    render_frame();
+
+    EXPECT_EQ(pixel(0, 0), 0x30);
+    EXPECT_EQ(pixel(7, 7), 0x30);
+    EXPECT_EQ(pixel(8, 0), 0x0F);
+    EXPECT_EQ(pixel(0, 8), 0x0F);
+}
+
+TEST_F(PpuRenderTest, test_grayscale_and_emphasis_are_stored_with_pixels) {
+    write_vram(0x3F00, {0x16});
+    render_frame(0, 0x1E | PpuMask::Grayscale | PpuMask::EmphasizeRed);
+    EXPECT_EQ(pixel(0, 0), 0x10 | Palette::EmphasizeRed);
+}
+
+TEST_F(PpuRenderTest, test_mid_line_write_matches_scanline_render) {
+    // Fill the nametable and patterns with something that isn't uniform,
+    // and put a few sprites on top.
+    std::vector<uint8_t> patterns(0x200);
+    for (size_t i = 0; i < patterns.size(); i++) {
+        patterns[i] = (i * 37) ^ (i >> 3);
+    }
+    write_vram(0x0000, patterns);
+    std::vector<uint8_t> nametable(0x400);
+    for (size_t i = 0; i < nametable.size(); i++) {
+        nametable[i] = i * 7;
+    }
+    write_vram(0x2000, nametable);
+    write_vram(0x3F00, {0x0F, 0x01, 0x11, 0x21, 0x0F, 0x02, 0x12, 0x22,
+                        0x0F, 0x03, 0x13, 0x23, 0x0F, 0x04, 0x14, 0x24,
+                        0x0F, 0x05, 0x15, 0x25});
+    ppu.cpu_write(0x2003, 0x00);
+    for (uint8_t byte: {0x04, 0x03, 0x00, 0x60, 0x06, 0x05, 0x40, 0x64}) {
+        ppu.cpu_write(0x2004, byte);
+    }
+    render_frame(3);
+    auto scanline_frame = ppu.get_framebuffer();
+
+    // Rewriting PPUMASK with the same value part way through each line
+    // makes the rest of it be drawn a dot at a time instead.
+    ppu.run_until(ppu.next_frame());
+    for (uint16_t line = 0; line < Ppu::SCREEN_HEIGHT; line++) {
+        ppu.run_until(ppu.get_dot_count() + 50 + line % 100);
+        ppu.cpu_write(0x2001, 0x1E);
+        ppu.run_until(ppu.get_dot_count() + 341 - 50 - line % 100);
+    }
+    EXPECT_EQ(scanline_frame, ppu.get_framebuffer());
+}
+
+TEST_F(PpuRenderTest, test_sprite_zero_hit_is_predicted) {
+    write_vram(0x0010, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF});
+    std::vector<uint8_t> nametable(0x3C0, 0x01);
+    write_vram(0x2000, nametable);
+    // Sprite 0 at (20, 10), which is drawn on lines 11-18.
+    ppu.cpu_write(0x2003, 0x00);
+    for (uint8_t byte: {10, 0x01, 0x00, 20}) {
+        ppu.cpu_write(0x2004, byte);
+    }
+    ppu.cpu_write(0x2000, 0x00);
+    ppu.cpu_write(0x2005, 0x00);
+    ppu.cpu_write(0x2005, 0x00);
+    ppu.cpu_write(0x2001, 0x1E);
+
+    // The pixel at x = 20 is drawn on dot 21.
+    uint64_t hit = ppu.next_frame() + 11 * 341 + 21;
+    while (ppu.get_dot_count() <= hit) {
+        EXPECT_EQ(ppu.cpu_read(0x2002) & 0x40, 0);
+        ppu.run_until(ppu.next_event());
+    }
+    EXPECT_EQ(ppu.get_dot_count(), hit + 1);
+    EXPECT_EQ(ppu.cpu_read(0x2002) & 0x40, 0x40);
+}
+
+TEST_F(PpuRenderTest, test_sprite_zero_hit_is_scheduled_without_stepping_lines) {
+    write_vram(0x0010, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF});
+    std::vector<uint8_t> nametable(0x3C0, 0x01);
+    write_vram(0x2000, nametable);
+    // Sprite 0 at (20, 100), with only its bottom row opaque, and every
+    // other sprite off screen.
+    write_vram(0x0027, {0x80});
+    for (int i = 0; i < 256; i++) {
+        ppu.cpu_write(0x2004, 0xFF);
+    }
+    ppu.cpu_write(0x2003, 0x00);
+    for (uint8_t byte: {100, 0x02, 0x00, 20}) {
+        ppu.cpu_write(0x2004, byte);
+    }
+    ppu.cpu_write(0x2000, 0x00);
+    ppu.cpu_write(0x2005, 0x00);
+    ppu.cpu_write(0x2005, 0x00);
+    ppu.cpu_write(0x2001, 0x1E);
+
+    // After vblank ends, the next event is the hit itself.
+    ppu.run_until(ppu.next_event());
+    EXPECT_EQ(ppu.cpu_read(0x2002) & 0x80, 0);
+    uint64_t hit = ppu.next_frame() + 108 * 341 + 21;
+    EXPECT_EQ(ppu.next_event(), hit + 1);
+    ppu.run_until(ppu.next_event());
+    EXPECT_EQ(ppu.cpu_read(0x2002) & 0x40, 0x40);
+}
+
+TEST_F(PpuRenderTest, test_sprite_overflow_is_set_by_ninth_sprite) {
+    // Move every sprite off screen, then put nine of them on line 51.
+    for (int i = 0; i < 256; i++) {
+        ppu.cpu_write(0x2004, 0xFF);
+    }
+    for (uint8_t sprite = 0; sprite < 9; sprite++) {
+        for (uint8_t byte: {50, 0x00, 0xFF, sprite * 8}) {
+            ppu.cpu_write(0x2004, byte);
+        }
+    }
+    // Attribute bits 2-4 don't exist.
+    ppu.cpu_write(0x2003, 0x02);
+    EXPECT_EQ(ppu.cpu_read(0x2004), 0xE3);
+
+    // The flag changing is an event, so a CPU polling for it is stopped in time.
+    ppu.cpu_write(0x2001, 0x1E);
+    ppu.run_until(ppu.next_frame());
+    uint64_t overflow = ppu.get_dot_count() + 51 * 341;
+    EXPECT_EQ(ppu.next_event(), overflow + 1);
+    ppu.run_until(overflow);
+    EXPECT_EQ(ppu.cpu_read(0x2002) & 0x20, 0);
+    ppu.run_until(ppu.get_dot_count() + 1);
+    EXPECT_EQ(ppu.cpu_read(0x2002) & 0x20, 0x20);
+}
+
+TEST_F(PpuRenderTest, test_unchanged_frame_is_repeated) {
+    write_vram(0x0010, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF});
+    std::vector<uint8_t> nametable(0x3C0, 0x01);
+    write_vram(0x2000, nametable);
+    write_vram(0x3F00, {0x0F, 0x30});
+    ppu.cpu_write(0x2003, 0x00);
+    for (uint8_t byte: {10, 0x01, 0x00, 20}) {
+        ppu.cpu_write(0x2004, byte);
+    }
+    render_frame();
+    EXPECT_FALSE(ppu.is_frame_repeated());
+    auto drawn = ppu.get_framebuffer();
+
+    // Writing the same scroll and sprites again doesn't change anything, and
+    // sprite 0 still hits on the same dot.
+    ppu.run_until(ppu.next_frame());
+    ppu.cpu_write(0x2005, 0x00);
+    ppu.cpu_write(0x2005, 0x00);
+    ppu.cpu_write(0x2003, 0x00);
+    ppu.cpu_write(0x2004, 10);
+    ppu.run_until(ppu.next_frame() + 11 * 341 + 21);
+    EXPECT_TRUE(ppu.is_frame_repeated());
+    EXPECT_EQ(ppu.cpu_read(0x2002) & 0x40, 0);
+    ppu.run_until(ppu.get_dot_count() + 1);
+    EXPECT_EQ(ppu.cpu_read(0x2002) & 0x40, 0x40);
+    ppu.run_until(ppu.get_dot_count() + 240 * 341);
+    EXPECT_EQ(drawn, ppu.get_framebuffer());
+
+    // A new color has to be drawn.
+    write_vram(0x3F01, {0x16});
+    render_frame();
+    EXPECT_FALSE(ppu.is_frame_repeated());
+    EXPECT_EQ(pixel(0, 0), 0x16);
+}
+
+TEST_F(PpuRenderTest, test_raster_effect_stops_frame_repeating) {
+    write_vram(0x0010, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF});
+    write_vram(0x2000, {0x01});
+    write_vram(0x3F00, {0x0F, 0x30});
+    render_frame();
+    render_frame();
+    EXPECT_TRUE(ppu.is_frame_repeated());
+
+    // Scrolling part way through a repeated frame draws the rest of it.
+    ppu.run_until(ppu.next_frame() + 4 * 341 + 100);
+    ppu.cpu_write(0x2005, 0x08);
+    ppu.cpu_write(0x2005, 0x00);
+    EXPECT_FALSE(ppu.is_frame_repeated());
+    ppu.run_until(ppu.get_dot_count() + 341);
+    EXPECT_EQ(pixel(0, 4), 0x30);
+    EXPECT_EQ(pixel(0, 5), 0x0F);
+}
+
+TEST_F(PpuRenderTest, test_background_follows_nametable_attribute_and_pattern_writes) {
+    write_vram(0x0010, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF});
+    write_vram(0x2000, {0x01});
+    write_vram(0x3F00, {0x0F, 0x30, 0x00, 0x00, 0x0F, 0x16});
+    render_frame();
+    EXPECT_EQ(pixel(0, 0), 0x30);
+
+    write_vram(0x23C0, {0x01}); // palette 1 for the top left tiles
+    render_frame();
+    EXPECT_EQ(pixel(0, 0), 0x16);
+
+    write_vram(0x0010, {0x7F}); // clear the first pixel of the tile's top row
+    render_frame();
+    EXPECT_EQ(pixel(0, 0), 0x0F);
+    EXPECT_EQ(pixel(1, 0), 0x16);
+
+    write_vram(0x2001, {0x01});
+    render_frame();
+    EXPECT_EQ(pixel(8, 1), 0x16);
+
+    // Scrolling wraps around into the next (mirrored) nametable.
+    render_frame(8);
+    EXPECT_EQ(pixel(0, 1), 0x16);
+    EXPECT_EQ(pixel(8, 1), 0x0F);
+    EXPECT_EQ(pixel(248, 1), 0x16);
+}
+
+TEST(PpuTest, test_chr_rom_write_doesnt_stop_frame_repeating) {
+    // An NROM image with 16KB of PRG-ROM and 8KB of CHR-ROM.
+    std::vector<uint8_t> rom(16 + 0x4000 + 0x2000);
+    std::copy_n("NES\x1A\x01\x01", 6, rom.begin());
+    rom[16 + 0x4000] = 0xFF;
+    Cartridge cartridge;
+    ASSERT_TRUE(cartridge.load_from_memory(rom));
+    Ppu ppu;
+    ppu.connect_cartridge(&cartridge);
+
+    ppu.cpu_write(0x2001, 0x08);
+    ppu.run_until(ppu.next_frame() + 240 * 341);
+    ppu.run_until(ppu.next_frame() + 240 * 341);
+    EXPECT_TRUE(ppu.is_frame_repeated());
+
+    // The write is dropped, so the next frame is still the same.
+    ppu.cpu_write(0x2006, 0x00);
+    ppu.cpu_write(0x2006, 0x00);
+    ppu.cpu_write(0x2007, 0x00);
+    EXPECT_EQ(ppu.ppu_read(0x0000), 0xFF);
+    ppu.run_until(ppu.next_frame() + 240 * 341);
+    EXPECT_TRUE(ppu.is_frame_repeated());
+}
+
+TEST(PpuTest, test_chr_bank_switch_only_redraws_background_tiles_using_it) {
+    // An MMC3 image with 32KB of PRG-ROM and 64KB of CHR-ROM.
+    std::vector<uint8_t> rom(16 + 0x8000 + 0x10000);
+    std::copy_n("NES\x1A\x02\x08\x40", 7, rom.begin());
+    Cartridge cartridge;
+    ASSERT_TRUE(cartridge.load_from_memory(rom));
+    Ppu ppu;
+    ppu.connect_cartridge(&cartridge);
+    auto switch_bank = [&](uint8_t bank, uint8_t value) {
+        cartridge.prg_write(0x8000, bank);
+        if (cartridge.prg_write(0x8001, value)) {
+            ppu.map_cartridge();
+        }
+    };
+
+    // Draw a frame of the background from $0000, with every tile using
+    // pattern 0.
+    ppu.cpu_write(0x2001, 0x08);
+    ppu.run_until(ppu.next_frame() + 240 * 341);
+    EXPECT_FALSE(ppu.is_background_dirty());
+
+    switch_bank(2, 9); // $1000-$13FF, used only by sprites
+    EXPECT_FALSE(ppu.is_background_dirty());
+    switch_bank(1, 12); // $0800-$0FFF, patterns no tile is using
+    EXPECT_FALSE(ppu.is_background_dirty());
+
+    // Writing CHR-ROM doesn't change any patterns.
+    ppu.cpu_write(0x2006, 0x00);
+    ppu.cpu_write(0x2006, 0x00);
+    ppu.cpu_write(0x2007, 0x55);
+    EXPECT_FALSE(ppu.is_background_dirty());
+
+    switch_bank(0, 14); // $0000-$07FF
+    EXPECT_TRUE(ppu.is_background_dirty());
+}
+
+TEST_F(PpuRenderTest, test_timing_only_frame_draws_nothing_but_keeps_flags) {
+    write_vram(0x0010, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF});
+    std::vector<uint8_t> nametable(0x3C0, 0x01);
+    write_vram(0x2000, nametable);
+    write_vram(0x3F00, {0x0F, 0x30});
+    // Sprite 0 at (20, 10), and nine sprites on line 51.
+    ppu.cpu_write(0x2003, 0x00);
+    for (uint8_t sprite = 0; sprite < 64; sprite++) {
+        int y = sprite == 0 ? 10 : sprite < 10 ? 50 : 0xFF;
+        for (uint8_t byte: {y, 0x01, 0x00, 20}) {
+            ppu.cpu_write(0x2004, byte);
+        }
+    }
+    render_frame();
+    auto drawn = ppu.get_framebuffer();
+
+    ppu.set_timing_only(true);
+    write_vram(0x3F01, {0x16});
+    ppu.cpu_write(0x2006, 0x00);
+    ppu.cpu_write(0x2006, 0x00);
+    uint64_t hit = ppu.next_frame() + 11 * 341 + 21;
+    ppu.run_until(ppu.next_frame());
+    EXPECT_EQ(ppu.next_event(), hit + 1);
+    ppu.run_until(hit);
+    EXPECT_EQ(ppu.cpu_read(0x2002) & 0x60, 0);
+    ppu.run_until(hit + 1);
+    EXPECT_EQ(ppu.cpu_read(0x2002) & 0x60, 0x40);
+    ppu.run_until(ppu.next_frame() + 52 * 341);
+    EXPECT_EQ(ppu.cpu_read(0x2002) & 0x60, 0x60);
+    ppu.run_until(ppu.next_frame() + 240 * 341);
+    EXPECT_EQ(drawn, ppu.get_framebuffer());
+
+    // The next frame drawn picks up the change made while drawing was off.
+    ppu.set_timing_only(false);
+    ppu.run_until(ppu.next_frame() + 240 * 341);
+    EXPECT_EQ(pixel(8, 0), 0x16);
+}
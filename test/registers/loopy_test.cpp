@@ -17,4 +17,17 @@ TEST(LoopyRegisterTest, test_set) {
     EXPECT_EQ(reg.get_value(), 0b0011001010111111);
     reg.set(LoopyRegister::CoarseX, 0b1000000);
     EXPECT_EQ(reg.get_value(), 0b0011001010100000);
-}
\ No newline at end of file
+}
+
+TEST(LoopyRegisterTest, test_flags_resolve_at_compile_time) {
+    static_assert(LoopyRegister::shift(LoopyRegister::CoarseY) == 5);
+    static_assert(LoopyRegister::shift(LoopyRegister::FineY) == 12);
+
+    constexpr uint16_t value = [] {
+        LoopyRegister reg;
+        reg.set(LoopyRegister::CoarseY, 0b10101);
+        reg.set(LoopyRegister::FineY, 0b011);
+        return reg.get_value();
+    }();
+    static_assert(value == 0b0011001010100000);
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include "../../src/registers/status.h"
+
+using Flag = StatusRegister::Flag;
+
+TEST(StatusRegisterTest, test_set_defaults) {
+    StatusRegister status;
+    status.set_defaults(Flag::Carry | Flag::Zero | Flag::Negative, 0x100);
+    EXPECT_TRUE(status.is_set(Flag::Carry));
+    EXPECT_TRUE(status.is_set(Flag::Zero));
+    EXPECT_FALSE(status.is_set(Flag::Negative));
+
+    status.set_defaults(Flag::Zero | Flag::Negative, 0x80);
+    EXPECT_TRUE(status.is_set(Flag::Carry));
+    EXPECT_FALSE(status.is_set(Flag::Zero));
+    EXPECT_TRUE(status.is_set(Flag::Negative));
+    EXPECT_EQ(status.get_value(), Flag::Carry | Flag::Negative);
+}
+
+TEST(StatusRegisterTest, test_set_defaults_keeps_other_flags) {
+    StatusRegister status;
+    status.set(Flag::InterruptDisable | Flag::Decimal);
+    status.set_defaults(Flag::Zero | Flag::Negative, 0x00);
+    EXPECT_EQ(status.get_value(), Flag::InterruptDisable | Flag::Decimal | Flag::Zero);
+}
+
+TEST(StatusRegisterTest, test_set_overrides_lazy_flag) {
+    StatusRegister status;
+    status.set_defaults(Flag::Carry, 0x1FF);
+    status.clear(Flag::Carry);
+    EXPECT_FALSE(status.is_set(Flag::Carry));
+
+    status.set_overflow(0x00);
+    status.set(Flag::Overflow);
+    EXPECT_TRUE(status.is_set(Flag::Overflow));
+}
+
+TEST(StatusRegisterTest, test_set_value_replaces_lazy_flags) {
+    StatusRegister status;
+    status.set_defaults(Flag::Carry | Flag::Zero | Flag::Negative, 0x180);
+    status.set_overflow(0x80);
+    status.set_value(Flag::Zero);
+    EXPECT_EQ(status.get_value(), Flag::Zero | Flag::Unused);
+}
+
+TEST(StatusRegisterTest, test_partial_zero_negative_update) {
+    StatusRegister status;
+    status.set_defaults(Flag::Zero | Flag::Negative, 0x80);
+    status.set_defaults(Flag::Zero, 0x01);
+    EXPECT_FALSE(status.is_set(Flag::Zero));
+    EXPECT_TRUE(status.is_set(Flag::Negative));
+}
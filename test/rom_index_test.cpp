@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include "../src/cartridge.h"
+#include "../src/hash.h"
+#include "../src/rom_index.h"
+
+namespace fs = std::filesystem;
+
+// Write an image with the given header flags 6 and PRG-ROM filled with the
+// byte, and return its contents.
+static std::vector<uint8_t> write_rom(const fs::path &path, uint8_t flags6, uint8_t fill, int prg_banks = 1) {
+    std::vector<uint8_t> image = {'N', 'E', 'S', 0x1A, static_cast<uint8_t>(prg_banks), 0, flags6};
+    image.resize(16 + prg_banks * 0x4000, fill);
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char *>(image.data()), image.size());
+    return image;
+}
+
+class RomIndexTest : public ::testing::Test {
+protected:
+    fs::path library = fs::path(testing::TempDir()) / "rom_index_test";
+
+    void SetUp() override {
+        fs::remove_all(library);
+        fs::create_directories(library / "more");
+    }
+};
+
+TEST_F(RomIndexTest, test_scan_corrects_headers_and_skips_unchanged_files) {
+    // A dump with a bad header (it's really UxROM with vertical mirroring),
+    // a good one, a file that isn't a ROM, and one that isn't a .nes file.
+    std::vector<uint8_t> bad = write_rom(library / "bad.nes", 0x00, 0x11, 2);
+    write_rom(library / "more" / "good.nes", 0x01, 0x22);
+    std::ofstream(library / "more" / "broken.nes") << "not a ROM";
+    write_rom(library / "readme.txt", 0x00, 0x33);
+
+    std::string database_path = (library / "corrections.txt").string();
+    std::ofstream(database_path) << "# crc32 mapper mirroring prg-ram\n"
+                                 << std::hex << hash::crc32(std::span(bad).subspan(16)) << " 2 V 0\n";
+    HeaderDatabase database;
+    ASSERT_TRUE(database.load(database_path));
+    ASSERT_EQ(database.size(), 1);
+
+    RomIndex index;
+    RomIndex::ScanStats stats = index.scan({library.string()}, database, 4);
+    EXPECT_EQ(stats.files, 3);
+    EXPECT_EQ(stats.read, 3);
+    EXPECT_EQ(stats.invalid, 1);
+    EXPECT_EQ(stats.corrected, 1);
+    ASSERT_EQ(index.get_entries().size(), 2);
+
+    const RomIndex::Entry *entry = index.find((library / "bad.nes").string());
+    ASSERT_NE(entry, nullptr);
+    EXPECT_TRUE(entry->corrected);
+    EXPECT_EQ(entry->info.mapper, Mapper::UxROM);
+    EXPECT_EQ(entry->info.mirror, Mapper::Vertical);
+    EXPECT_EQ(entry->info.prg_ram_size, 0);
+
+    // The index survives a round trip, and a rescan only reads what changed.
+    std::string index_path = (library / "roms.idx").string();
+    ASSERT_TRUE(index.save(index_path));
+    RomIndex reloaded;
+    ASSERT_TRUE(reloaded.load(index_path));
+    EXPECT_EQ(reloaded.find((library / "more" / "good.nes").string())->crc32,
+              index.find((library / "more" / "good.nes").string())->crc32);
+    write_rom(library / "more" / "good.nes", 0x01, 0x22, 2);
+    EXPECT_EQ(reloaded.find((library / "more" / "good.nes").string()), nullptr);
+    stats = reloaded.scan({library.string()}, database, 2);
+    EXPECT_EQ(stats.read, 2); // the changed ROM, and the one that isn't valid
+
+    // Loading with the indexed info uses the corrected header.
+    Cartridge cartridge;
+    entry = reloaded.find((library / "bad.nes").string());
+    ASSERT_NE(entry, nullptr);
+    ASSERT_TRUE(cartridge.load((library / "bad.nes").string(), &entry->info));
+    EXPECT_EQ(cartridge.get_info().mapper, Mapper::UxROM);
+    EXPECT_TRUE(cartridge.prg_write(0x8000, 1));
+}
+
+TEST_F(RomIndexTest, test_nes2_header_fields) {
+    std::vector<uint8_t> image = write_rom(library / "nes2.nes", 0x42, 0);
+    image[7] = 0x18; // NES 2.0, mapper high nibble 1
+    image[8] = 0x01; // mapper bits 8-11
+    image[10] = 0x70; // 8KB of battery-backed PRG-RAM
+    RomInfo info;
+    ASSERT_TRUE(RomInfo::parse(image, info));
+    EXPECT_EQ(info.version, 2);
+    EXPECT_EQ(info.mapper, 0x114);
+    EXPECT_TRUE(info.battery);
+    EXPECT_EQ(info.prg_ram_size, 0x2000);
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include "../src/bus.h"
+#include "../src/save_ram.h"
+
+namespace fs = std::filesystem;
+
+static std::vector<uint8_t> read_file(const fs::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), {}};
+}
+
+TEST(SaveRamTest, test_writes_are_flushed_to_the_file) {
+    fs::path path = fs::path(testing::TempDir()) / "save_ram_test.sav";
+    fs::remove(path);
+    {
+        std::unique_ptr<SaveRam> save = SaveRam::open(path.string(), 0x2000);
+        ASSERT_NE(save, nullptr);
+        EXPECT_EQ(fs::file_size(path), 0x2000);
+        EXPECT_FALSE(save->is_dirty());
+
+        save->write(0x0010, 0x42);
+        save->write(0x1FFF, 0x43);
+        EXPECT_TRUE(save->is_dirty());
+        save->flush();
+        EXPECT_FALSE(save->is_dirty());
+        std::vector<uint8_t> contents = read_file(path);
+        EXPECT_EQ(contents[0x0010], 0x42);
+        EXPECT_EQ(contents[0x1FFF], 0x43);
+    }
+
+    // Reopening it picks up where it left off.
+    std::unique_ptr<SaveRam> save = SaveRam::open(path.string(), 0x2000);
+    ASSERT_NE(save, nullptr);
+    EXPECT_EQ(save->bytes()[0x0010], 0x42);
+}
+
+TEST(SaveRamTest, test_dirty_pages_are_flushed_in_the_background) {
+    fs::path path = fs::path(testing::TempDir()) / "save_ram_background_test.sav";
+    fs::remove(path);
+    SaveRam::set_flush_interval(std::chrono::milliseconds(5));
+    std::unique_ptr<SaveRam> save = SaveRam::open(path.string(), 0x2000);
+    ASSERT_NE(save, nullptr);
+
+    save->write(0x1000, 0x01);
+    for (int i = 0; i < 1000 && save->is_dirty(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_FALSE(save->is_dirty());
+    SaveRam::set_flush_interval(std::chrono::milliseconds(1000));
+}
+
+TEST(SaveRamTest, test_battery_backed_prg_ram_is_saved_next_to_the_rom) {
+    fs::path rom = fs::path(testing::TempDir()) / "save_ram_test.nes";
+    fs::path sav = fs::path(testing::TempDir()) / "save_ram_test.sav";
+    fs::remove(sav);
+    std::ofstream(rom, std::ios::binary)
+            .write("NES\x1A\x01\x01\x02\0\0\0\0\0\0\0\0\0", 16) // NROM with a battery
+            .write(std::string(0x6000, '\0').data(), 0x6000);
+
+    for (int run = 0; run < 2; run++) {
+        Cartridge cartridge;
+        ASSERT_TRUE(cartridge.load(rom.string()));
+        ASSERT_TRUE(cartridge.is_prg_ram_saved());
+        Bus bus;
+        bus.load_cartridge(&cartridge);
+
+        // Reads come straight from the page, writes through the cartridge.
+        EXPECT_NE(bus.page_memory(0x6000), nullptr);
+        EXPECT_EQ(bus.read(0x7FFF), run ? 0x99 : 0x00);
+        bus.write(0x7FFF, 0x99);
+        EXPECT_EQ(bus.read(0x7FFF), 0x99);
+    }
+    EXPECT_EQ(read_file(sav)[0x1FFF], 0x99);
+}
@@ -0,0 +1,18 @@
+#include <gtest/gtest.h>
+#include "../src/scheduler.h"
+
+using Event = Scheduler::Event;
+
+TEST(SchedulerTest, test_next_is_earliest_event) {
+    Scheduler scheduler;
+    EXPECT_EQ(scheduler.next(), UINT64_MAX);
+
+    scheduler.schedule(Event::FrameEnd, 500);
+    scheduler.schedule(Event::Ppu, 200);
+    EXPECT_EQ(scheduler.next(), 200);
+    EXPECT_TRUE(scheduler.is_due(Event::Ppu, 200));
+    EXPECT_FALSE(scheduler.is_due(Event::FrameEnd, 200));
+
+    scheduler.cancel(Event::Ppu);
+    EXPECT_EQ(scheduler.next(), 500);
+}
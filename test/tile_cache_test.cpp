@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include "../src/tile_cache.h"
+
+TEST(TileCacheTest, test_rows_are_decoded_from_bitplanes) {
+    std::vector<uint8_t> chr(32);
+    chr[16 + 2] = 0b10100000; // tile 1, row 2, low plane
+    chr[16 + 10] = 0b01100000; // tile 1, row 2, high plane
+    TileCache cache(chr.data(), chr.size());
+
+    const uint8_t *row = cache.row(16 + 2);
+    EXPECT_EQ(row[0], 1);
+    EXPECT_EQ(row[1], 2);
+    EXPECT_EQ(row[2], 3);
+    EXPECT_EQ(row[3], 0);
+}
+
+TEST(TileCacheTest, test_written_tiles_are_decoded_again) {
+    std::vector<uint8_t> chr(16);
+    TileCache cache(chr.data(), chr.size());
+    EXPECT_EQ(cache.row(0)[7], 0);
+
+    chr[8] = 0x01;
+    cache.invalidate(8);
+    EXPECT_EQ(cache.row(0)[7], 2);
+}
+
+TEST(TileCacheTest, test_caches_are_shared_by_identical_chr_rom) {
+    // Two images with the same CHR-ROM after different PRG-ROM.
+    std::vector<uint8_t> bytes(0x2010, 0xFF);
+    bytes[0] = 0x01;
+    auto image = RomImage::copy(bytes);
+    bytes[0] = 0x02;
+    auto copy = RomImage::copy(bytes);
+    auto other = RomImage::copy(std::vector<uint8_t>(0x2010, 0x0F));
+
+    auto cache = TileCache::shared(image, image->bytes().subspan(0x10));
+    EXPECT_EQ(TileCache::shared(copy, copy->bytes().subspan(0x10)), cache);
+    EXPECT_NE(TileCache::shared(other, other->bytes().subspan(0x10)), cache);
+
+    // The cache keeps reading from its image after everyone else let go.
+    image.reset();
+    copy.reset();
+    EXPECT_EQ(cache->row(0)[0], 3);
+    copy = RomImage::copy(bytes);
+    EXPECT_EQ(TileCache::shared(copy, copy->bytes().subspan(0x10)), cache);
+}
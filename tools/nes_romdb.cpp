@@ -0,0 +1,79 @@
+#include "../src/header_database.h"
+#include "../src/rom_index.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+using clock_type = std::chrono::high_resolution_clock;
+
+static void print_usage(const char *program) {
+    std::cout << "Usage: " << program << " <index> <directory>... [--database FILE] [--threads N] [--list]" << std::endl;
+}
+
+// Build or update the index of a ROM library, so the emulator can load ROMs
+// from it (with --index) without checking their headers again.
+int main(int argc, char **argv) {
+    std::string index_path;
+    std::vector<std::string> directories;
+    std::string database_path;
+    unsigned threads = std::thread::hardware_concurrency();
+    bool list = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--database") == 0 && i + 1 < argc) {
+            database_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--list") == 0) {
+            list = true;
+        } else if (argv[i][0] == '-') {
+            std::cerr << "Unknown argument " << argv[i] << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        } else if (index_path.empty()) {
+            index_path = argv[i];
+        } else {
+            directories.emplace_back(argv[i]);
+        }
+    }
+    if (index_path.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    HeaderDatabase database;
+    if (!database_path.empty() && !database.load(database_path)) {
+        return 1;
+    }
+
+    // Start from the existing index (if there is one) so unchanged files
+    // aren't read again.
+    RomIndex index;
+    if (std::filesystem::exists(index_path) && !index.load(index_path)) {
+        return 1;
+    }
+    if (!directories.empty()) {
+        auto start = clock_type::now();
+        RomIndex::ScanStats stats = index.scan(directories, database, threads);
+        std::chrono::duration<double> elapsed = clock_type::now() - start;
+        if (!index.save(index_path)) {
+            return 1;
+        }
+        std::cout << "ROMs:          " << stats.files << std::endl;
+        std::cout << "Read:          " << stats.read << std::endl;
+        std::cout << "Invalid:       " << stats.invalid << std::endl;
+        std::cout << "Corrected:     " << stats.corrected << std::endl;
+        std::cout << "Wall time:     " << elapsed.count() << " s" << std::endl;
+    }
+
+    if (list) {
+        for (const RomIndex::Entry &entry: index.get_entries()) {
+            std::cout << std::hex << std::setw(8) << std::setfill('0') << entry.crc32 << std::dec
+                      << "  mapper " << std::setw(3) << std::setfill(' ') << entry.info.mapper
+                      << (entry.corrected ? "  corrected  " : "             ") << entry.path << std::endl;
+        }
+    }
+    return 0;
+}